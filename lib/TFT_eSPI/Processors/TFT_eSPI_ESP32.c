@@ -24,6 +24,21 @@
   #else
     spi_host_device_t spi_host = VSPI_HOST;
   #endif
+
+  // Queued DMA: one block = CASET, column data, PASET, row data, RAMWR, pixel data.
+  // The pixel transaction "user" points back at its block so completion can be recognised,
+  // command transactions use 0 and data transactions 1 for the D/C callback.
+  #define DMA_BLOCK_TRANS 6
+  typedef struct {
+    spi_transaction_t trans[DMA_BLOCK_TRANS];
+    void* user;
+  } dma_block_t;
+
+  dma_block_t* dmaBlocks       = nullptr;
+  uint8_t      dmaBlockDepth   = 0;
+  uint8_t      dmaBlockNext    = 0;
+  uint8_t      dmaBlocksQueued = 0;
+  void       (*dmaDoneCb)(void* user) = nullptr;
 #endif
 
 #if !defined (TFT_PARALLEL_8_BIT)
@@ -520,13 +535,10 @@ bool TFT_eSPI::dmaBusy(void)
 {
   if (!DMA_Enabled || !spiBusyCheck) return false;
 
-  spi_transaction_t *rtrans;
-  esp_err_t ret;
   uint8_t checks = spiBusyCheck;
   for (int i = 0; i < checks; ++i)
   {
-    ret = spi_device_get_trans_result(dmaHAL, &rtrans, 0);
-    if (ret == ESP_OK) spiBusyCheck--;
+    if (!dmaReapOne(0)) break;
   }
 
   //Serial.print("spiBusyCheck=");Serial.println(spiBusyCheck);
@@ -542,14 +554,152 @@ bool TFT_eSPI::dmaBusy(void)
 void TFT_eSPI::dmaWait(void)
 {
   if (!DMA_Enabled || !spiBusyCheck) return;
-  spi_transaction_t *rtrans;
-  esp_err_t ret;
-  for (int i = 0; i < spiBusyCheck; ++i)
+  while (spiBusyCheck)
   {
-    ret = spi_device_get_trans_result(dmaHAL, &rtrans, portMAX_DELAY);
+    bool ok = dmaReapOne(portMAX_DELAY);
+    assert(ok);
+  }
+}
+
+
+/***************************************************************************************
+** Function name:           dmaReapOne
+** Description:             Collect one finished transaction, report finished blocks
+***************************************************************************************/
+bool TFT_eSPI::dmaReapOne(TickType_t wait)
+{
+  if (!spiBusyCheck) return false;
+
+  spi_transaction_t *rtrans;
+  esp_err_t ret = spi_device_get_trans_result(dmaHAL, &rtrans, wait);
+  if (ret != ESP_OK) return false;
+  spiBusyCheck--;
+
+  // Last transaction of a queued block, the buffer can be handed back
+  if ((uintptr_t)rtrans->user > 1) {
+    dma_block_t* blk = (dma_block_t*)rtrans->user;
+    dmaBlocksQueued--;
+    if (dmaDoneCb) dmaDoneCb(blk->user);
+  }
+  return true;
+}
+
+
+/***************************************************************************************
+** Function name:           dmaQueued
+** Description:             Number of queued blocks not yet reported done
+***************************************************************************************/
+uint8_t TFT_eSPI::dmaQueued(void)
+{
+  return dmaBlocksQueued;
+}
+
+
+/***************************************************************************************
+** Function name:           pushImageDMAQueued
+** Description:             Queue a window + image block, up to dmaBlockDepth in flight
+***************************************************************************************/
+// No clipping and no byte swapping, buffer must be in panel byte order and DMA capable
+bool TFT_eSPI::pushImageDMAQueued(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* buffer, void* user)
+{
+  return startWindowDMAQueued(x, y, w, h, buffer, w * h, user);
+}
+
+
+/***************************************************************************************
+** Function name:           dmaNextBlock
+** Description:             Take the next block descriptor, caller makes sure it is free
+***************************************************************************************/
+static inline dma_block_t* dmaNextBlock(void)
+{
+  dma_block_t* blk = &dmaBlocks[dmaBlockNext];
+  dmaBlockNext = (dmaBlockNext + 1) % dmaBlockDepth;
+  return blk;
+}
+
+
+/***************************************************************************************
+** Function name:           startWindowDMAQueued
+** Description:             Queue window commands and the first "len" pixels of the window
+***************************************************************************************/
+bool TFT_eSPI::startWindowDMAQueued(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* buffer, uint32_t len, void* user)
+{
+  if (!DMA_Enabled || !dmaBlocks) return false;
+  if ((w < 1) || (h < 1) || (x < _vpX) || (y < _vpY) || ((x + w) > _vpW) || ((y + h) > _vpH)) return false;
+  if ((len == 0) || (len > (uint32_t)(w * h))) return false;
+
+  // Oldest block must finish before its descriptors are reused
+  while (dmaBlocksQueued >= dmaBlockDepth) dmaReapOne(portMAX_DELAY);
+
+  dma_block_t* blk = dmaNextBlock();
+
+  int32_t x1 = x + w - 1;
+  int32_t y1 = y + h - 1;
+#ifdef CGRAM_OFFSET
+  x  += colstart;
+  x1 += colstart;
+  y  += rowstart;
+  y1 += rowstart;
+#endif
+
+  spi_transaction_t* t = blk->trans;
+  memset(t, 0, sizeof(blk->trans));
+  blk->user = user;
+
+  t[0].tx_data[0] = TFT_CASET;
+  t[1].tx_data[0] = x >> 8;  t[1].tx_data[1] = x;  t[1].tx_data[2] = x1 >> 8; t[1].tx_data[3] = x1;
+  t[2].tx_data[0] = TFT_PASET;
+  t[3].tx_data[0] = y >> 8;  t[3].tx_data[1] = y;  t[3].tx_data[2] = y1 >> 8; t[3].tx_data[3] = y1;
+  t[4].tx_data[0] = TFT_RAMWR;
+
+  for (int i = 0; i < 5; i++) {
+    t[i].flags  = SPI_TRANS_USE_TXDATA;
+    t[i].length = (i & 1) ? 32 : 8;           // Commands 8 bits, coordinates 32 bits
+    t[i].user   = (void *)(uintptr_t)(i & 1); // D/C low for commands, high for data
+  }
+
+  t[5].tx_buffer = buffer;
+  t[5].length    = len * 16;
+  t[5].user      = blk;                       // Non-zero so D/C is high
+
+  for (int i = 0; i < DMA_BLOCK_TRANS; i++) {
+    esp_err_t ret = spi_device_queue_trans(dmaHAL, &t[i], portMAX_DELAY);
     assert(ret == ESP_OK);
   }
-  spiBusyCheck = 0;
+
+  spiBusyCheck += DMA_BLOCK_TRANS;
+  dmaBlocksQueued++;
+  return true;
+}
+
+
+/***************************************************************************************
+** Function name:           pushPixelsDMAQueued
+** Description:             Queue more pixels into the window opened by startWindowDMAQueued
+***************************************************************************************/
+// RAMWR keeps streaming across transactions as long as no command is sent in between,
+// so this relies on CS staying low (ctrl_cs false and startWrite() held by the sketch)
+bool TFT_eSPI::pushPixelsDMAQueued(uint16_t* buffer, uint32_t len, void* user)
+{
+  if (!DMA_Enabled || !dmaBlocks || (len == 0)) return false;
+
+  while (dmaBlocksQueued >= dmaBlockDepth) dmaReapOne(portMAX_DELAY);
+
+  dma_block_t* blk = dmaNextBlock();
+  spi_transaction_t* t = &blk->trans[DMA_BLOCK_TRANS - 1];
+  memset(t, 0, sizeof(spi_transaction_t));
+  blk->user = user;
+
+  t->tx_buffer = buffer;
+  t->length    = len * 16;
+  t->user      = blk;
+
+  esp_err_t ret = spi_device_queue_trans(dmaHAL, t, portMAX_DELAY);
+  assert(ret == ESP_OK);
+
+  spiBusyCheck++;
+  dmaBlocksQueued++;
+  return true;
 }
 
 
@@ -685,6 +835,9 @@ bool TFT_eSPI::initDMA(bool ctrl_cs)
 {
   if (DMA_Enabled) return false;
 
+  // Queued mode needs room for every transaction of every block and the D/C callback
+  int queue_size = dmaBlocks ? dmaBlockDepth * DMA_BLOCK_TRANS : 1;
+
   esp_err_t ret;
   spi_bus_config_t buscfg = {
     .mosi_io_num = TFT_MOSI,
@@ -712,8 +865,8 @@ bool TFT_eSPI::initDMA(bool ctrl_cs)
     .input_delay_ns = 0,
     .spics_io_num = pin,
     .flags = SPI_DEVICE_NO_DUMMY, //0,
-    .queue_size = 1,
-    .pre_cb = 0, //dc_callback, //Callback to handle D/C line
+    .queue_size = queue_size,
+    .pre_cb = dmaBlocks ? (transaction_cb_t)dc_callback : nullptr, //Callback to handle D/C line
     .post_cb = 0
   };
   ret = spi_bus_initialize(spi_host, &buscfg, 1);
@@ -726,6 +879,31 @@ bool TFT_eSPI::initDMA(bool ctrl_cs)
   return true;
 }
 
+/***************************************************************************************
+** Function name:           initDMAQueue
+** Description:             Initialise the DMA engine with a queue of "depth" image blocks
+***************************************************************************************/
+bool TFT_eSPI::initDMAQueue(uint8_t depth, void (*done_cb)(void* user), bool ctrl_cs)
+{
+  if (DMA_Enabled || depth == 0) return false;
+  // spiBusyCheck is 8 bits wide
+  if (depth * DMA_BLOCK_TRANS > 255) depth = 255 / DMA_BLOCK_TRANS;
+
+  dmaBlocks = (dma_block_t*)calloc(depth, sizeof(dma_block_t));
+  if (!dmaBlocks) return false;
+  dmaBlockDepth   = depth;
+  dmaBlockNext    = 0;
+  dmaBlocksQueued = 0;
+  dmaDoneCb       = done_cb;
+
+  if (!initDMA(ctrl_cs)) {
+    free(dmaBlocks);
+    dmaBlocks = nullptr;
+    return false;
+  }
+  return true;
+}
+
 /***************************************************************************************
 ** Function name:           deInitDMA
 ** Description:             Disconnect the DMA engine from SPI
@@ -733,9 +911,15 @@ bool TFT_eSPI::initDMA(bool ctrl_cs)
 void TFT_eSPI::deInitDMA(void)
 {
   if (!DMA_Enabled) return;
+  dmaWait();
   spi_bus_remove_device(dmaHAL);
   spi_bus_free(spi_host);
   DMA_Enabled = false;
+  if (dmaBlocks) {
+    free(dmaBlocks);
+    dmaBlocks = nullptr;
+    dmaBlockDepth = 0;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -641,6 +641,26 @@ class TFT_eSPI : public Print { friend class TFT_eSprite; // Sprite class has ac
   bool     DMA_Enabled = false;   // Flag for DMA enabled state
   uint8_t  spiBusyCheck = 0;      // Number of ESP32 transfer buffers to check
 
+#if defined (ESP32_DMA) && !defined (TFT_PARALLEL_8_BIT)
+           // Queued DMA (ESP32 SPI only) - keeps up to "depth" image blocks in flight. Each block carries its
+           // own window commands and transaction descriptors, so the sketch can prepare the next block while
+           // earlier ones are still being clocked out. Use instead of initDMA().
+           // Buffers must be in DMA capable memory and already in panel byte order (no swap, no clipping),
+           // and must not be modified until done_cb(user) reports them. done_cb is called in the caller's
+           // task from pushImageDMAQueued(), dmaBusy() or dmaWait(), never from an interrupt.
+           // Call dmaWait() before using any other drawing function.
+  bool     initDMAQueue(uint8_t depth, void (*done_cb)(void* user), bool ctrl_cs = false);
+           // Returns false if the block is outside the viewport or the queue is not initialised,
+           // waits for the oldest block to finish if all "depth" blocks are in flight
+  bool     pushImageDMAQueued(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* buffer, void* user = nullptr);
+           // Same, but the w*h window is only started with the first "len" pixels from buffer, the rest
+           // follows with pushPixelsDMAQueued() - one set of window commands for several buffers.
+           // Each buffer is its own block and is reported to done_cb on its own.
+  bool     startWindowDMAQueued(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* buffer, uint32_t len, void* user = nullptr);
+  bool     pushPixelsDMAQueued(uint16_t* buffer, uint32_t len, void* user = nullptr);
+  uint8_t  dmaQueued(void);       // Number of queued blocks not yet reported done
+#endif
+
   // Bare metal functions
   void     startWrite(void);                         // Begin SPI transaction
   void     writeColor(uint16_t color, uint32_t len); // Deprecated, use pushBlock()
@@ -705,6 +725,11 @@ class TFT_eSPI : public Print { friend class TFT_eSprite; // Sprite class has ac
            // Byte read prototype
   uint8_t  readByte(void);
 
+#if defined (ESP32_DMA) && !defined (TFT_PARALLEL_8_BIT)
+           // Collect one finished DMA transaction, reports finished queued blocks to the done callback
+  bool     dmaReapOne(TickType_t wait);
+#endif
+
            // GPIO parallel bus input/output direction control
   void     busDir(uint32_t mask, uint8_t mode);
 
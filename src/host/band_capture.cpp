@@ -0,0 +1,187 @@
+#include "band_capture.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <thread>
+#include "platform.h"
+
+static void put_le16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    put_le16(p, v & 0xFFFF);
+    put_le16(p + 2, v >> 16);
+}
+
+static uint16_t get_le16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t get_le32(const uint8_t* p) { return get_le16(p) | ((uint32_t)get_le16(p + 2) << 16); }
+
+static size_t pad4(size_t n) { return (n + 3) & ~(size_t)3; }
+
+// 先把 hdr_len 字节放进 hdr，剩下的放进 payload，和 socket 的分散读一样
+static void scatter(const uint8_t* data, size_t len, uint8_t* hdr, size_t hdr_len,
+                    uint8_t* payload, size_t payload_cap, bool* truncated) {
+    size_t h = len < hdr_len ? len : hdr_len;
+    memcpy(hdr, data, h);
+    size_t rest = len - h;
+    if (rest > payload_cap) {
+        rest = payload_cap;
+        *truncated = true;
+    }
+    memcpy(payload, data + h, rest);
+}
+
+// ---------------- CaptureWriter ----------------
+
+bool CaptureWriter::open(const char* path) {
+    close();
+    fp_ = fopen(path, "wb");
+    if (!fp_) return false;
+    count_ = 0;
+    uint8_t h[CAPTURE_FILE_HEADER_BYTES];
+    memset(h, 0, sizeof(h));
+    memcpy(h, BAND_CAPTURE_MAGIC, 4);
+    put_le16(h + 4, BAND_CAPTURE_VERSION);
+    return fwrite(h, sizeof(h), 1, fp_) == 1;
+}
+
+bool CaptureWriter::write(uint32_t t_us, const uint8_t* data, size_t len) {
+    if (!fp_ || len > CAPTURE_MAX_DATAGRAM) return false;
+    uint8_t h[CAPTURE_RECORD_HEADER_BYTES];
+    memset(h, 0, sizeof(h));
+    put_le32(h, t_us);
+    put_le16(h + 4, (uint16_t)len);
+    static const uint8_t zero[3] = {0, 0, 0};
+    if (fwrite(h, sizeof(h), 1, fp_) != 1 || fwrite(data, 1, len, fp_) != len ||
+        fwrite(zero, 1, pad4(len) - len, fp_) != pad4(len) - len) {
+        return false;
+    }
+    count_++;
+    return true;
+}
+
+bool CaptureWriter::close() {
+    if (!fp_) return true;
+    uint8_t n[4];
+    put_le32(n, count_);
+    bool ok = fseek(fp_, 8, SEEK_SET) == 0 && fwrite(n, sizeof(n), 1, fp_) == 1;
+    ok = fclose(fp_) == 0 && ok;
+    fp_ = nullptr;
+    return ok;
+}
+
+// ---------------- CaptureReader ----------------
+
+bool CaptureReader::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < CAPTURE_FILE_HEADER_BYTES) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // 映射建好以后文件描述符就不用了
+    if (p == MAP_FAILED) return false;
+    base_ = (const uint8_t*)p;
+    size_ = st.st_size;
+    if (memcmp(base_, BAND_CAPTURE_MAGIC, 4) || get_le16(base_ + 4) != BAND_CAPTURE_VERSION) {
+        close();
+        return false;
+    }
+    count_ = get_le32(base_ + 8);
+    rewind();
+    return true;
+}
+
+void CaptureReader::close() {
+    if (base_) munmap((void*)base_, size_);
+    base_ = nullptr;
+    size_ = 0;
+}
+
+bool CaptureReader::peek(CaptureRecord& r) const {
+    if (!base_ || (count_ && index_ >= count_) || pos_ + CAPTURE_RECORD_HEADER_BYTES > size_) return false;
+    const uint8_t* h = base_ + pos_;
+    r.t_us = get_le32(h);
+    r.len = get_le16(h + 4);
+    if (pos_ + CAPTURE_RECORD_HEADER_BYTES + r.len > size_) return false; // 录制被打断，最后一条不完整
+    r.data = h + CAPTURE_RECORD_HEADER_BYTES;
+    return true;
+}
+
+bool CaptureReader::next(CaptureRecord& r) {
+    if (!peek(r)) return false;
+    pos_ += CAPTURE_RECORD_HEADER_BYTES + pad4(r.len);
+    index_++;
+    return true;
+}
+
+void CaptureReader::rewind() {
+    pos_ = CAPTURE_FILE_HEADER_BYTES;
+    index_ = 0;
+}
+
+// ---------------- RecordingTransport ----------------
+
+int RecordingTransport::recv(uint8_t* hdr, size_t hdr_len,
+                             uint8_t* payload, size_t payload_cap, bool* truncated) {
+    int n = inner_.recv(hdr, hdr_len, payload, payload_cap, truncated);
+    if (n <= 0) return n;
+    uint32_t now = micros();
+    if (!started_) {
+        started_ = true;
+        start_us_ = now;
+    }
+    // 负载放不下时被截掉的部分已经丢了，只记收到的
+    size_t h = (size_t)n < hdr_len ? n : hdr_len;
+    size_t rest = n - h;
+    if (rest > payload_cap) rest = payload_cap;
+    memcpy(buf_, hdr, h);
+    memcpy(buf_ + h, payload, rest);
+    writer_.write(now - start_us_, buf_, h + rest);
+    return n;
+}
+
+// ---------------- ReplayTransport ----------------
+
+bool ReplayTransport::begin(uint16_t port) {
+    (void)port;
+    reader_.rewind();
+    replayed = 0;
+    start_us_ = micros();
+    return true;
+}
+
+bool ReplayTransport::due(const CaptureRecord& r) const {
+    return !paced_ || (int32_t)(micros() - start_us_ - r.t_us) >= 0;
+}
+
+bool ReplayTransport::wait(uint32_t timeout_ms) {
+    CaptureRecord r;
+    if (!reader_.peek(r)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+        return false;
+    }
+    if (due(r)) return true;
+    uint32_t left_us = r.t_us - (micros() - start_us_);
+    if (left_us > timeout_ms * 1000) left_us = timeout_ms * 1000;
+    std::this_thread::sleep_for(std::chrono::microseconds(left_us));
+    return due(r);
+}
+
+int ReplayTransport::recv(uint8_t* hdr, size_t hdr_len,
+                          uint8_t* payload, size_t payload_cap, bool* truncated) {
+    CaptureRecord r;
+    if (!reader_.peek(r) || !due(r)) return 0;
+    reader_.next(r);
+    scatter(r.data, r.len, hdr, hdr_len, payload, payload_cap, truncated);
+    replayed++;
+    return r.len;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "band_transport.h"
+
+// ================= 抓包文件（.bcap） =================
+// 按到达顺序存原始数据报和到达时间，回放时喂给同一套收包/缩放/绘制代码，
+// 同一份抓包每次跑出来的数字可以直接比，不受 WiFi 和发送间隔影响。
+// 文件头 16 字节：
+//   [0..3]   "BCAP"   [4..5] 版本 BAND_CAPTURE_VERSION   [6..7] 保留
+//   [8..11]  记录数，录完时回填；0 表示录制被打断，读的时候按文件长度算
+//   [12..15] 保留
+// 每条记录 8 字节头 + 数据报，补齐到 4 字节，整个文件 mmap 进来就能直接遍历：
+//   [0..3]   距第一个包的微秒数   [4..5] 数据报长度   [6..7] 保留
+// 多字节字段都是小端
+#define BAND_CAPTURE_MAGIC "BCAP"
+#define BAND_CAPTURE_VERSION 1
+#define CAPTURE_FILE_HEADER_BYTES 16
+#define CAPTURE_RECORD_HEADER_BYTES 8
+#define CAPTURE_MAX_DATAGRAM 65535
+
+struct CaptureRecord {
+    uint32_t t_us;
+    uint16_t len;
+    const uint8_t* data; // 指向 mmap 进来的文件
+};
+
+// 顺序写一个抓包文件
+class CaptureWriter {
+public:
+    CaptureWriter() : fp_(nullptr), count_(0) {}
+    ~CaptureWriter() { close(); }
+
+    bool open(const char* path);
+    // t_us 是距第一个包的微秒数，调用方保证不减
+    bool write(uint32_t t_us, const uint8_t* data, size_t len);
+    // 回填记录数，返回 false 表示文件没写完整
+    bool close();
+
+    uint32_t count() const { return count_; }
+
+private:
+    FILE* fp_;
+    uint32_t count_;
+};
+
+// mmap 整个抓包文件，按顺序取记录
+class CaptureReader {
+public:
+    CaptureReader() : base_(nullptr), size_(0), pos_(0), count_(0), index_(0) {}
+    ~CaptureReader() { close(); }
+
+    // 文件头不对返回 false
+    bool open(const char* path);
+    void close();
+
+    // 取下一条记录，读完了或者后面的记录不完整返回 false
+    bool next(CaptureRecord& r);
+    // 看下一条记录但不前进
+    bool peek(CaptureRecord& r) const;
+    void rewind();
+
+    // 文件头里的记录数，0 表示录制被打断，不知道
+    uint32_t count() const { return count_; }
+    uint32_t index() const { return index_; }
+
+private:
+    const uint8_t* base_;
+    size_t size_;
+    size_t pos_;
+    uint32_t count_;
+    uint32_t index_;
+};
+
+// 收到的每个数据报都原样记下来，其余的交给里面的 transport
+class RecordingTransport : public BandTransport {
+public:
+    RecordingTransport(BandTransport& inner, CaptureWriter& writer)
+        : inner_(inner), writer_(writer), started_(false), start_us_(0) {}
+
+    bool begin(uint16_t port) override { return inner_.begin(port); }
+    void end() override { inner_.end(); }
+    bool wait(uint32_t timeout_ms) override { return inner_.wait(timeout_ms); }
+    int recv(uint8_t* hdr, size_t hdr_len,
+             uint8_t* payload, size_t payload_cap, bool* truncated) override;
+    bool reply(const uint8_t* data, size_t len) override { return inner_.reply(data, len); }
+
+private:
+    BandTransport& inner_;
+    CaptureWriter& writer_;
+    bool started_;
+    uint32_t start_us_;
+    uint8_t buf_[CAPTURE_MAX_DATAGRAM];
+};
+
+// 把抓包文件当成收包来源。paced 时按记录里的时间间隔放包（从 begin 开始算），
+// 否则有多少给多少，收包循环能跑多快就多快。反馈包和 NACK 没有发送端接，直接丢掉
+class ReplayTransport : public BandTransport {
+public:
+    ReplayTransport(CaptureReader& reader, bool paced)
+        : replayed(0), reader_(reader), paced_(paced), start_us_(0) {}
+
+    bool begin(uint16_t port) override;
+    bool wait(uint32_t timeout_ms) override;
+    int recv(uint8_t* hdr, size_t hdr_len,
+             uint8_t* payload, size_t payload_cap, bool* truncated) override;
+
+    // 记录都放完了
+    bool done() const {
+        CaptureRecord r;
+        return !reader_.peek(r);
+    }
+
+    uint32_t replayed; // 已经放出去的数据报
+
+private:
+    bool due(const CaptureRecord& r) const;
+
+    CaptureReader& reader_;
+    bool paced_;
+    uint32_t start_us_;
+};
@@ -0,0 +1,372 @@
+#include "band_encoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <jpeglib.h> // 要在 stdio.h 后面
+#include "band_codec.h"
+#include "frame_source.h"
+
+static inline bool samePx(const uint8_t* a, const uint8_t* b, int i, int bpp) {
+    return bpp == 1 ? a[i] == b[i] : (a[i * 2] == b[i * 2] && a[i * 2 + 1] == b[i * 2 + 1]);
+}
+
+size_t xor_delta_encode(const uint8_t* cur, uint8_t* ref, int bpp, int n, bool key, uint8_t* out) {
+    if (key) memset(ref, 0, (size_t)n * bpp);
+    uint8_t* o = out;
+    int i = 0;
+    while (i < n) {
+        int zeros = 0;
+        while (i + zeros < n && zeros < 255 && samePx(cur, ref, i + zeros, bpp)) zeros++;
+        i += zeros;
+        // 异或值一直延续到连着两个不变的像素为止，单个不变的像素不值得再开一个记号。
+        // 这样除了第一个记号和满 255 之后的记号，每个记号至少跳过 2 个像素，抵得上 2 字节的开销
+        int lits = 0;
+        while (i + lits < n && lits < 255) {
+            int j = i + lits;
+            if (j + 1 < n && samePx(cur, ref, j, bpp) && samePx(cur, ref, j + 1, bpp)) break;
+            lits++;
+        }
+        *o++ = (uint8_t)zeros;
+        *o++ = (uint8_t)lits;
+        for (int k = 0; k < lits * bpp; k++) {
+            *o++ = cur[i * bpp + k] ^ ref[i * bpp + k];
+        }
+        memcpy(ref + i * bpp, cur + i * bpp, (size_t)lits * bpp);
+        i += lits;
+    }
+    return o - out;
+}
+
+size_t packbits_encode(const uint8_t* cur, int bpp, int n, uint8_t* out) {
+    uint8_t* o = out;
+    int litStart = 0, lits = 0;
+    int i = 0;
+    while (i < n) {
+        int run = 1;
+        while (i + run < n && run < 128 && samePx(cur + i * bpp, cur + (i + run) * bpp, 0, bpp)) run++;
+        if (run >= 3 || (run == 2 && lits == 0)) {
+            if (lits) {
+                *o++ = (uint8_t)(lits - 1);
+                memcpy(o, cur + litStart * bpp, (size_t)lits * bpp);
+                o += lits * bpp;
+                lits = 0;
+            }
+            *o++ = (uint8_t)(257 - run);
+            memcpy(o, cur + i * bpp, bpp);
+            o += bpp;
+            i += run;
+            continue;
+        }
+        if (lits == 0) litStart = i;
+        lits++;
+        i++;
+        if (lits == 128) {
+            *o++ = 127;
+            memcpy(o, cur + litStart * bpp, (size_t)lits * bpp);
+            o += lits * bpp;
+            lits = 0;
+        }
+    }
+    if (lits) {
+        *o++ = (uint8_t)(lits - 1);
+        memcpy(o, cur + litStart * bpp, (size_t)lits * bpp);
+        o += lits * bpp;
+    }
+    return o - out;
+}
+
+static inline int wrap(int v, int bits) {
+    int m = 1 << bits;
+    return ((v + m / 2) & (m - 1)) - m / 2;
+}
+
+size_t qoi565_encode(const uint8_t* cur, int base, int n, uint8_t* out) {
+    uint8_t* o = out;
+    uint16_t index[64];
+    memset(index, 0, sizeof(index));
+    uint16_t prev = 0;
+    int run = 0;
+    for (int i = 0; i < n; i++) {
+        const uint8_t* p = cur + i * 2;
+        uint16_t v = base == BAND_COLOR_RGB565_BE ? (p[0] << 8) | p[1] : p[0] | (p[1] << 8);
+        if (v == prev) {
+            run++;
+            if (run == QOI565_RUN_MAX) {
+                *o++ = QOI565_OP_RUN | (run - 1);
+                run = 0;
+            }
+            continue;
+        }
+        if (run) {
+            *o++ = QOI565_OP_RUN | (run - 1);
+            run = 0;
+        }
+        int h = qoi565_hash(v);
+        if (index[h] == v) {
+            *o++ = QOI565_OP_INDEX | h;
+        } else {
+            index[h] = v;
+            int dr = wrap((v >> 11) - (prev >> 11), 5);
+            int dg = wrap(((v >> 5) & 63) - ((prev >> 5) & 63), 6);
+            int db = wrap((v & 31) - (prev & 31), 5);
+            int half = dg >> 1;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                *o++ = QOI565_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+            } else if (dr - half >= -8 && dr - half <= 7 && db - half >= -8 && db - half <= 7) {
+                *o++ = QOI565_OP_LUMA | (dg + 32);
+                *o++ = ((dr - half + 8) << 4) | (db - half + 8);
+            } else {
+                *o++ = QOI565_OP_RGB;
+                *o++ = v >> 8;
+                *o++ = v & 0xFF;
+            }
+        }
+        prev = v;
+    }
+    if (run) *o++ = QOI565_OP_RUN | (run - 1);
+    return o - out;
+}
+
+// ================= 调色板 =================
+static inline int c565_r(uint16_t v) { return ((v >> 11) << 3) | (v >> 13); }
+static inline int c565_g(uint16_t v) { return (((v >> 5) & 63) << 2) | ((v >> 9) & 3); }
+static inline int c565_b(uint16_t v) { return ((v & 31) << 3) | ((v >> 2) & 7); }
+
+PaletteEncoder::PaletteEncoder() : count_(0), colors_(0), version_(0) {
+    memset(pal_, 0, sizeof(pal_));
+}
+
+namespace {
+struct ColorCount {
+    uint16_t v;
+    uint32_t n;
+};
+struct Box {
+    int begin, end; // colors 里的下标范围
+    int range, channel;
+};
+}
+
+static int channelOf(uint16_t v, int ch) {
+    return ch == 0 ? c565_r(v) : (ch == 1 ? c565_g(v) : c565_b(v));
+}
+
+static void measure(const std::vector<ColorCount>& colors, Box& b) {
+    int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+    for (int i = b.begin; i < b.end; i++) {
+        for (int ch = 0; ch < 3; ch++) {
+            int c = channelOf(colors[i].v, ch);
+            lo[ch] = std::min(lo[ch], c);
+            hi[ch] = std::max(hi[ch], c);
+        }
+    }
+    b.range = -1;
+    for (int ch = 0; ch < 3; ch++) {
+        if (hi[ch] - lo[ch] > b.range) {
+            b.range = hi[ch] - lo[ch];
+            b.channel = ch;
+        }
+    }
+}
+
+bool PaletteEncoder::build(const uint8_t* rgb, int npx, int colors) {
+    std::vector<uint32_t> hist(65536, 0);
+    for (int i = 0; i < npx; i++) hist[rgb888_to_565(rgb + i * 3)]++;
+    std::vector<ColorCount> cs;
+    for (int v = 0; v < 65536; v++) {
+        if (hist[v]) cs.push_back(ColorCount{(uint16_t)v, hist[v]});
+    }
+
+    uint16_t pal[256];
+    int count = 0;
+    if ((int)cs.size() <= colors) {
+        // 颜色够少，原样放进调色板
+        for (size_t i = 0; i < cs.size(); i++) pal[count++] = cs[i].v;
+    } else {
+        // 每次切范围最大的盒子，按那个通道排序后在加权中位数处切开
+        std::vector<Box> boxes(1);
+        boxes[0].begin = 0;
+        boxes[0].end = cs.size();
+        measure(cs, boxes[0]);
+        while ((int)boxes.size() < colors) {
+            int pick = -1;
+            for (size_t i = 0; i < boxes.size(); i++) {
+                if (boxes[i].end - boxes[i].begin < 2) continue;
+                if (pick < 0 || boxes[i].range > boxes[pick].range) pick = i;
+            }
+            if (pick < 0 || boxes[pick].range == 0) break;
+            Box b = boxes[pick];
+            int ch = b.channel;
+            std::sort(cs.begin() + b.begin, cs.begin() + b.end, [ch](const ColorCount& x, const ColorCount& y) {
+                return channelOf(x.v, ch) < channelOf(y.v, ch);
+            });
+            uint64_t total = 0, acc = 0;
+            for (int i = b.begin; i < b.end; i++) total += cs[i].n;
+            int mid = b.begin + 1;
+            for (int i = b.begin; i < b.end - 1; i++) {
+                acc += cs[i].n;
+                mid = i + 1;
+                if (acc * 2 >= total) break;
+            }
+            Box l = b, r = b;
+            l.end = mid;
+            r.begin = mid;
+            measure(cs, l);
+            measure(cs, r);
+            boxes[pick] = l;
+            boxes.push_back(r);
+        }
+        for (size_t k = 0; k < boxes.size(); k++) {
+            uint64_t sr = 0, sg = 0, sb = 0, sn = 0;
+            for (int i = boxes[k].begin; i < boxes[k].end; i++) {
+                sr += (uint64_t)c565_r(cs[i].v) * cs[i].n;
+                sg += (uint64_t)c565_g(cs[i].v) * cs[i].n;
+                sb += (uint64_t)c565_b(cs[i].v) * cs[i].n;
+                sn += cs[i].n;
+            }
+            uint8_t p[3] = {(uint8_t)(sr / sn), (uint8_t)(sg / sn), (uint8_t)(sb / sn)};
+            pal[count++] = rgb888_to_565(p);
+        }
+    }
+
+    bool changed = count != count_ || colors != colors_ || memcmp(pal, pal_, count * 2) != 0;
+    if (changed) {
+        memcpy(pal_, pal, count * 2);
+        count_ = count;
+        colors_ = colors;
+        version_++;
+        memset(cache_, 0xFF, sizeof(cache_));
+    }
+    return changed;
+}
+
+uint8_t PaletteEncoder::nearest(uint16_t c) {
+    if (cache_[c] >= 0) return cache_[c];
+    int r = c565_r(c), g = c565_g(c), b = c565_b(c);
+    int best = 0, bestD = 1 << 30;
+    for (int i = 0; i < count_; i++) {
+        int dr = r - c565_r(pal_[i]), dg = g - c565_g(pal_[i]), db = b - c565_b(pal_[i]);
+        int d = dr * dr * 3 + dg * dg * 4 + db * db * 2;
+        if (d < bestD) {
+            bestD = d;
+            best = i;
+        }
+    }
+    cache_[c] = best;
+    return best;
+}
+
+size_t PaletteEncoder::encode(const uint8_t* rgb, int n, uint8_t* out) {
+    if (colors_ <= 16) {
+        for (int i = 0; i < n; i += 2) {
+            uint8_t hi = nearest(rgb888_to_565(rgb + i * 3));
+            uint8_t lo = i + 1 < n ? nearest(rgb888_to_565(rgb + (i + 1) * 3)) : 0;
+            out[i / 2] = (hi << 4) | lo;
+        }
+        return (n + 1) / 2;
+    }
+    for (int i = 0; i < n; i++) out[i] = nearest(rgb888_to_565(rgb + i * 3));
+    return n;
+}
+
+size_t PaletteEncoder::writeEntries(uint8_t* out) const {
+    for (int i = 0; i < count_; i++) {
+        out[i * 2] = pal_[i] >> 8;
+        out[i * 2 + 1] = pal_[i] & 0xFF;
+    }
+    return count_ * 2;
+}
+
+static inline uint8_t clip8(int x) {
+    return x < 0 ? 0 : (x > 255 ? 255 : x);
+}
+
+size_t yuv420_encode(const uint8_t* rgb, int w, int lines, uint8_t* out) {
+    int cw = w / 2, ch = (lines + 1) / 2;
+    uint8_t* y = out;
+    uint8_t* u = y + w * lines;
+    uint8_t* v = u + cw * ch;
+    for (int i = 0; i < w * lines; i++) {
+        const uint8_t* p = rgb + i * 3;
+        y[i] = (19595 * p[0] + 38470 * p[1] + 7471 * p[2] + 32768) >> 16;
+    }
+    for (int cy = 0; cy < ch; cy++) {
+        int rows = cy * 2 + 1 < lines ? 2 : 1; // 行数是奇数时最后一行单独一行色度
+        for (int cx = 0; cx < cw; cx++) {
+            int r = 0, g = 0, b = 0;
+            for (int dy = 0; dy < rows; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    const uint8_t* p = rgb + ((cy * 2 + dy) * w + cx * 2 + dx) * 3;
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                }
+            }
+            int cnt = rows * 2;
+            r = (r + cnt / 2) / cnt;
+            g = (g + cnt / 2) / cnt;
+            b = (b + cnt / 2) / cnt;
+            u[cy * cw + cx] = clip8(((-11058 * r - 21710 * g + 32768 * b + 32768) >> 16) + 128);
+            v[cy * cw + cx] = clip8(((32768 * r - 27439 * g - 5329 * b + 32768) >> 16) + 128);
+        }
+    }
+    return band_yuv420_bytes(w, lines);
+}
+
+size_t jpeg_slice_encode(const uint8_t* rgb, int w, int lines, int quality, uint8_t* out, size_t cap) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr err;
+    cinfo.err = jpeg_std_error(&err);
+    jpeg_create_compress(&cinfo);
+    unsigned char* buf = nullptr;
+    unsigned long len = 0;
+    jpeg_mem_dest(&cinfo, &buf, &len);
+    cinfo.image_width = w;
+    cinfo.image_height = lines;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    cinfo.optimize_coding = TRUE;
+    cinfo.write_JFIF_header = FALSE; // TJpgDec 不需要，省 18 字节
+    // 4:2:2：MCU 16x8，8 行的 band 不用补行
+    cinfo.comp_info[0].h_samp_factor = 2;
+    cinfo.comp_info[0].v_samp_factor = 1;
+    jpeg_start_compress(&cinfo, TRUE);
+    while ((int)cinfo.next_scanline < lines) {
+        JSAMPROW r = const_cast<uint8_t*>(rgb + (size_t)cinfo.next_scanline * w * 3);
+        jpeg_write_scanlines(&cinfo, &r, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    size_t n = len <= cap ? len : 0;
+    if (n) memcpy(out, buf, n);
+    free(buf);
+    return n;
+}
+
+size_t band_encode(int codec, const uint8_t* cur, uint8_t* ref, int base, int n, bool key, uint8_t* out) {
+    int bpp = band_bytes_per_px(base);
+    switch (codec) {
+    case BAND_CODEC_XOR: return xor_delta_encode(cur, ref, bpp, n, key, out);
+    case BAND_CODEC_RLE: return packbits_encode(cur, bpp, n, out);
+    case BAND_CODEC_QOI: return qoi565_encode(cur, base, n, out);
+    }
+    return 0;
+}
+
+size_t band_encode_bound(int codec, int base, int n) {
+    int bpp = band_bytes_per_px(base);
+    switch (codec) {
+    case BAND_CODEC_XOR: return xor_delta_bound(bpp, n);
+    case BAND_CODEC_RLE: return packbits_bound(bpp, n);
+    case BAND_CODEC_QOI: return qoi565_bound(n);
+    case BAND_CODEC_PAL4: return (n + 1) / 2;
+    case BAND_CODEC_PAL8: return n;
+    case BAND_CODEC_YUV420: return (size_t)n * 2;
+    case BAND_CODEC_JPEG: return (size_t)n * bpp; // 比原始 band 大就不用
+    }
+    return 0;
+}
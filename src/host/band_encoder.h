@@ -0,0 +1,86 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "band_protocol.h"
+
+// ================= band 压缩格式的编码（PC 发送端用） =================
+// 格式和接收端的解码见 screen_share/band_codec.h。输出不含 band 头和编码字节
+
+// XOR 增量：cur 是 n 个像素的线上字节，ref 是发送端记下的接收端参考帧里对应的一段，编码完更新成 cur。
+// key 时先把 ref 清零，和接收端一致。out 至少要 n*bpp + 2*(n/255+1) 字节，返回写了多少字节
+size_t xor_delta_encode(const uint8_t* cur, uint8_t* ref, int bpp, int n, bool key, uint8_t* out);
+
+// 最坏情况（全是异或值）的编码长度
+static inline size_t xor_delta_bound(int bpp, int n) {
+    return (size_t)n * bpp + 2 * (n / 255 + 1);
+}
+
+// PackBits：3 个以上相同的像素编成重复，2 个相同的只在前面没有原样像素时才单独编
+size_t packbits_encode(const uint8_t* cur, int bpp, int n, uint8_t* out);
+
+static inline size_t packbits_bound(int bpp, int n) {
+    return (size_t)n * bpp + (n + 127) / 128;
+}
+
+// 仿 QOI 的 RGB565，cur 是 base(BAND_COLOR_RGB565 / RGB565_BE) 的线上字节，每个 band 单独编码
+size_t qoi565_encode(const uint8_t* cur, int base, int n, uint8_t* out);
+
+static inline size_t qoi565_bound(int n) {
+    return (size_t)n * 3;
+}
+
+// ================= 调色板（BAND_CODEC_PAL4 / PAL8） =================
+// 调色板编码直接吃 RGB888：每帧在 RGB565 直方图上做中位切分得到调色板，再把像素映射成最近的索引。
+// 颜色数不超过调色板大小时（界面、文字）是无损的
+class PaletteEncoder {
+public:
+    PaletteEncoder();
+
+    // 按一帧画面重新生成调色板，colors 是 16 或 256。返回 true 表示内容和上一帧不同，版本号加了一
+    bool build(const uint8_t* rgb, int npx, int colors);
+
+    // n 个 RGB888 像素编成索引，4 位时高 4 位在前，返回字节数
+    size_t encode(const uint8_t* rgb, int n, uint8_t* out);
+
+    int entries() const { return count_; }
+    uint8_t version() const { return version_; }
+    // 调色板包的负载：entries 个大端 RGB565
+    size_t writeEntries(uint8_t* out) const;
+
+private:
+    uint8_t nearest(uint16_t c565);
+
+    uint16_t pal_[256];
+    int count_;
+    int colors_;
+    uint8_t version_;
+    int16_t cache_[65536]; // RGB565 → 索引，-1 表示还没算
+};
+
+// ================= YUV 4:2:0（BAND_CODEC_YUV420） =================
+// w x lines 个 RGB888 像素转成 Y、U、V 三个平面（全范围 BT.601），色度取 2x2 的平均，返回字节数
+size_t yuv420_encode(const uint8_t* rgb, int w, int lines, uint8_t* out);
+
+// ================= JPEG 切片（BAND_CODEC_JPEG） =================
+// w x lines 个 RGB888 像素编成一张独立的基线 JPEG（4:2:2，优化过的哈夫曼表，不带 JFIF 头），
+// 超过 cap 字节返回 0，发送端改发原始 band
+size_t jpeg_slice_encode(const uint8_t* rgb, int w, int lines, int quality, uint8_t* out, size_t cap);
+
+// ================= 按编码方式分派 =================
+// ref 只有 XOR 用，其他编码传 nullptr 也可以
+size_t band_encode(int codec, const uint8_t* cur, uint8_t* ref, int base, int n, bool key, uint8_t* out);
+// YUV420 按 1 行的 band 算（2n），行数多时实际接近 1.5n，准确的长度用 band_yuv420_bytes
+size_t band_encode_bound(int codec, int base, int n);
+// 没有跨 band 状态的无损编码，压缩后更大时发送端可以直接发原始 band
+static inline bool band_codec_stateless(int codec) {
+    return codec == BAND_CODEC_RLE || codec == BAND_CODEC_QOI;
+}
+
+static inline bool band_codec_palette(int codec) {
+    return codec == BAND_CODEC_PAL4 || codec == BAND_CODEC_PAL8;
+}
+
+// 直接吃 RGB888、不管 --color 的有损编码
+static inline bool band_codec_rgb(int codec) {
+    return band_codec_palette(codec) || codec == BAND_CODEC_YUV420 || codec == BAND_CODEC_JPEG;
+}
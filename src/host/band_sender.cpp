@@ -0,0 +1,748 @@
+// ================= band 协议的压测发送端 =================
+// 按 processUDPPacket 解析的格式发包：frame_id、y0、分辨率/颜色/行数标志字节 + 像素。
+// 画面可以是程序生成的，也可以从文件读（每帧 size*size*3 字节的 RGB888，读到结尾从头循环，
+// 比如 ffmpeg -i in.mp4 -vf scale=240:240 -pix_fmt rgb24 -f rawvideo frames.rgb）。
+//   pio run -e native_sender && .pio/build/native_sender/program --host 192.168.1.50 --res 240 --color 565 --lines 3 --interval 0.00075
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "band_protocol.h"
+#include "band_encoder.h"
+#include "frame_source.h"
+
+#define UDP_MTU_PAYLOAD 1472 // 1500 的以太网 MTU 减去 IP 和 UDP 头，超过了 IP 层要分片
+
+struct SenderOptions {
+    const char* host = "127.0.0.1";
+    int port = 8888;
+    int size = 240;
+    int color = BAND_COLOR_RGB565;
+    int lines = 3;
+    double interval = 0;   // 包间隔，秒；0 表示不限速
+    double rate = 0;       // 按字节限速，字节/秒；和 interval 二选一
+    int frames = 0;        // 0 表示一直发
+    double seconds = 0;    // 0 表示不限时
+    const char* file = nullptr;
+    bool desktop = false;  // 生成桌面类画面：静止背景 + 闪烁光标 + 移动的小窗口
+    bool noise = false;    // 每帧随机改几个矩形，序列固定，两次运行发的画面一样
+    int tileW = 0;         // >0 时发 v2 瓦片包，只发和上一帧不同的瓦片
+    int tileH = 0;
+    int codec = 0;         // BAND_CODEC_*，0 表示不压缩
+    int keyInterval = 30;  // 压缩时每个 band 每隔多少帧发一次关键帧，各 band 错开
+    int quality = 75;      // JPEG 质量
+    int fec = 0;           // >0 时每这么多个 band 发一个 XOR 校验包
+    double loss = 0;       // 模拟丢包率，0-1，丢掉的包照样占发送时间
+    unsigned seed = 1;     // 模拟丢包的随机种子，同一个种子丢的包一样
+    double aimdMax = 0;    // >0 时按接收端的反馈包自动调包速，不超过这个 pps
+    double aimdStep = 100; // 每个没有拥塞的反馈包加多少 pps
+    int nack = 0;          // >0 时记住最近这么多帧的 band，按接收端的 NACK 重发
+    double reorder = 0;    // 模拟乱序，0-1，被选中的包推迟到下一个包后面发
+    int pack = 0;          // >0 时同一帧相邻的 band 拼成不超过这么多字节的多 band 包
+    int frag = 0;          // >0 时每个 band 拆成不超过这么多字节的分片发，--lines 可以到 FRAG_MAX_LINES
+};
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --host ip        接收端地址，默认 127.0.0.1\n"
+            "  -p port          端口，默认 8888\n"
+            "  --res 240|180|120\n"
+            "  --color 565|565be|332\n"
+            "  --lines n        每个包的行数 1-15（--frag 时 1-32），默认 3\n"
+            "  --pps n          每秒包数\n"
+            "  --interval s     包间隔(秒)，和客户端的 interval 一样，比如 0.00075\n"
+            "  --mbps n         按字节限速，MB/s，用来在相同带宽下比较不同编码\n"
+            "  --frames n       发多少帧后退出\n"
+            "  -t seconds       发多少秒后退出\n"
+            "  --file path      RGB888 原始帧文件，不给就用生成的画面\n"
+            "  --pattern bar|desktop|noise  生成的画面，默认 bar\n"
+            "  --tile WxH       发瓦片包，只发变化的瓦片（源分辨率下的尺寸）；180 时高度向上补成 3 的倍数\n"
+            "  --codec xor|rle|qoi|pal4|pal8|yuv|jpeg  band 压缩方式，--color 是解码后的像素格式(qoi 只能 565)；\n"
+            "                   pal4/pal8 每帧先发 16/256 色的调色板，band 里是索引；yuv 是 YUV 4:2:0，每像素 12 位\n"
+            "                   （--lines 最好是偶数，奇数时最后一行单独带一行色度）；\n"
+            "                   jpeg 每个 band 是一张独立的 JPEG，--lines 放大后不能超过 8 行；\n"
+            "                   这四种和 --color 无关，只有 jpeg 比原始 band 还大或者超过一个 MTU 时按 --color 发原始 band，\n"
+            "                   原始 band 超过一个 MTU 时拆成几个小 band；jpeg 不能和 --fec 一起用\n"
+            "  --key-interval n 每个 band 隔多少帧发一次关键帧，默认 30\n"
+            "  --quality n      JPEG 质量 1-100，默认 75\n"
+            "  --fec k          每 k 个 band 发一个 XOR 校验包（k 最大 16），接收端能补回每组丢掉的一个 band\n"
+            "  --loss pct       模拟丢包，按百分比随机不发（包括校验包）\n"
+            "  --seed n         模拟丢包的随机种子，默认 1\n"
+            "  --aimd max       按接收端的反馈包自动调包速（加性增、乘性减），从 --pps 开始（默认 1000），不超过 max pps\n"
+            "  --aimd-step n    没有拥塞时每个反馈包加多少 pps，默认 100\n"
+            "  --nack frames    记住最近这么多帧的 band，按接收端的 NACK 重发（接收端要开 --nack）\n"
+            "  --reorder pct    模拟乱序，按百分比把包推迟到下一个包后面发\n"
+            "  --pack bytes     同一帧相邻的 band 拼成一个包，每个包不超过这么多字节（比如 1472），小 band 时省包数\n"
+            "  --frag bytes     每个 band 拆成不超过这么多字节的分片（比如 1472），band 可以到 32 行，\n"
+            "                   接收端拼好后一次 DMA 发出去；只能 --res 240、不压缩，不能和 --tile/--fec/--nack/--pack 一起用\n",
+            prog);
+}
+
+static bool parseArgs(int argc, char** argv, SenderOptions& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) return false;
+        i++;
+        if (!strcmp(a, "--host")) o.host = v;
+        else if (!strcmp(a, "-p")) o.port = atoi(v);
+        else if (!strcmp(a, "--res")) o.size = atoi(v);
+        else if (!strcmp(a, "--color")) {
+            if (!strcmp(v, "565")) o.color = BAND_COLOR_RGB565;
+            else if (!strcmp(v, "565be")) o.color = BAND_COLOR_RGB565_BE;
+            else if (!strcmp(v, "332")) o.color = BAND_COLOR_RGB332;
+            else return false;
+        }
+        else if (!strcmp(a, "--lines")) o.lines = atoi(v);
+        else if (!strcmp(a, "--pps")) o.interval = atof(v) > 0 ? 1.0 / atof(v) : 0;
+        else if (!strcmp(a, "--interval")) o.interval = atof(v);
+        else if (!strcmp(a, "--mbps")) o.rate = atof(v) * 1e6;
+        else if (!strcmp(a, "--frames")) o.frames = atoi(v);
+        else if (!strcmp(a, "-t")) o.seconds = atof(v);
+        else if (!strcmp(a, "--file")) o.file = v;
+        else if (!strcmp(a, "--pattern")) {
+            if (!strcmp(v, "desktop")) o.desktop = true;
+            else if (!strcmp(v, "noise")) o.noise = true;
+            else if (strcmp(v, "bar")) return false;
+        }
+        else if (!strcmp(a, "--tile")) {
+            if (sscanf(v, "%dx%d", &o.tileW, &o.tileH) != 2 || o.tileW <= 0 || o.tileH <= 0) return false;
+        }
+        else if (!strcmp(a, "--codec")) {
+            if (!strcmp(v, "xor")) o.codec = BAND_CODEC_XOR;
+            else if (!strcmp(v, "rle")) o.codec = BAND_CODEC_RLE;
+            else if (!strcmp(v, "qoi")) o.codec = BAND_CODEC_QOI;
+            else if (!strcmp(v, "pal4")) o.codec = BAND_CODEC_PAL4;
+            else if (!strcmp(v, "pal8")) o.codec = BAND_CODEC_PAL8;
+            else if (!strcmp(v, "yuv")) o.codec = BAND_CODEC_YUV420;
+            else if (!strcmp(v, "jpeg")) o.codec = BAND_CODEC_JPEG;
+            else return false;
+        }
+        else if (!strcmp(a, "--key-interval")) o.keyInterval = atoi(v);
+        else if (!strcmp(a, "--quality")) o.quality = atoi(v);
+        else if (!strcmp(a, "--fec")) o.fec = atoi(v);
+        else if (!strcmp(a, "--loss")) o.loss = atof(v) / 100;
+        else if (!strcmp(a, "--seed")) o.seed = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--aimd")) o.aimdMax = atof(v);
+        else if (!strcmp(a, "--aimd-step")) o.aimdStep = atof(v);
+        else if (!strcmp(a, "--nack")) o.nack = atoi(v);
+        else if (!strcmp(a, "--reorder")) o.reorder = atof(v) / 100;
+        else if (!strcmp(a, "--pack")) o.pack = atoi(v);
+        else if (!strcmp(a, "--frag")) o.frag = atoi(v);
+        else return false;
+    }
+    if (o.codec && (o.tileW || o.keyInterval <= 0)) return false; // 瓦片包不压缩
+    if (o.codec == BAND_CODEC_QOI && o.color == BAND_COLOR_RGB332) return false;
+    if (o.quality < 1 || o.quality > 100) return false;
+    if (o.fec < 0 || o.fec > BAND_FEC_MAX_K || (o.fec && o.tileW) || o.loss < 0 || o.loss >= 1) return false;
+    // 校验包按整个 band 算，JPEG 改发的原始 band 可能拆成几个，凑不成组
+    if (o.fec && o.codec == BAND_CODEC_JPEG) return false;
+    if (o.aimdMax < 0 || (o.aimdMax > 0 && (o.rate > 0 || o.aimdStep <= 0))) return false; // 自动调速只调包速
+    if (o.nack < 0 || o.nack > 64 || (o.nack && o.tileW) || o.reorder < 0 || o.reorder >= 1) return false;
+    // 接收端整个包先收进一个槽位
+    if (o.pack < 0 || o.pack > BAND_HEADER_BYTES + 240 * 8 * 2 || (o.pack && o.tileW)) return false;
+    // 分片只拆不压缩的 240 宽 band，分片数用接收端 32 位的位图记
+    if (o.frag < 0 || o.frag > BAND_HEADER_BYTES + 240 * 8 * 2 ||
+        (o.frag && (o.frag <= FRAG_HEADER_BYTES || o.size != 240 || o.codec || o.tileW || o.fec ||
+                    o.nack || o.pack))) return false;
+    if (o.frag && (240 * o.lines * band_bytes_per_px(o.color) + o.frag - FRAG_HEADER_BYTES - 1) /
+                  (o.frag - FRAG_HEADER_BYTES) > FRAG_MAX_COUNT) return false;
+    return (o.size == 240 || o.size == 180 || o.size == 120) && o.lines >= 1 &&
+           o.lines <= (o.frag ? FRAG_MAX_LINES : 15) &&
+           o.tileW <= o.size && o.tileH <= o.size;
+}
+
+// ================= 按反馈调速（AIMD） =================
+// 接收端定期发回收包数、丢包数和空闲槽位（见 band_feedback.h）。没有丢包、空闲槽位也够时每个反馈包加一点包速，
+// 接收端丢包（没有槽位/过期）或者空闲槽位不到四分之一时乘性减速，包速就停在接收端刚好吃得下的位置。
+// 链路上丢的包接收端看不到，不会让这里减速，那是 FEC 的事
+struct RateController {
+    double pps;
+    double minPps = 100;
+    double maxPps;
+    double step;
+    double backoff = 0.85;
+    uint64_t feedbacks = 0, decreases = 0, missed = 0; // missed: 序号跳掉的反馈包
+    bool have = false;
+    FeedbackStats last = FeedbackStats();
+
+    // 收到一个统计反馈包，返回新的包速
+    double onFeedback(const FeedbackStats& s) {
+        if (have) missed += (uint16_t)(s.seq - last.seq - 1);
+        have = true;
+        last = s;
+        feedbacks++;
+        if (s.drops > 0 || s.freeSlots * 4 < s.slots) {
+            pps = std::max(minPps, pps * backoff);
+            decreases++;
+        } else {
+            pps = std::min(maxPps, pps + step);
+        }
+        return pps;
+    }
+};
+
+// ================= 按 NACK 重发 =================
+// 记住最近几帧发出去的 band（按帧号和 y0 找），收到 NACK 就把和缺的行相交的 band 原样再发一次，
+// 头部加 BAND_RETX_FLAG。同一个 band 最多重发 RETX_MAX_TRIES 次，已经不在窗口里的帧不管。
+// 重发的 band 到得太晚（那几行已经被更新的帧画了）由接收端丢掉，见 band_nack.h
+#define RETX_MAX_TRIES 2
+
+struct RetransmitWindow {
+    struct Frame {
+        bool valid = false;
+        uint16_t frame_id = 0;
+        std::vector<std::vector<std::vector<uint8_t>>> bands; // 下标是 y0 / lines，一个 band 拆成几个包时都记下
+        std::vector<uint8_t> tries;
+    };
+    std::vector<Frame> frames; // 按帧号取模
+    int lines = 1;
+    uint64_t nacks = 0, resent = 0, resentBytes = 0, expired = 0; // expired: 要的帧已经不在窗口里
+
+    void begin(int window, int size, int bandLines) {
+        lines = bandLines;
+        frames.resize(window);
+        for (Frame& f : frames) {
+            f.bands.resize((size + lines - 1) / lines);
+            f.tries.resize(f.bands.size());
+        }
+    }
+
+    void startFrame(uint16_t id) {
+        Frame& f = frames[id % frames.size()];
+        f.valid = true;
+        f.frame_id = id;
+        for (size_t i = 0; i < f.bands.size(); i++) {
+            f.bands[i].clear();
+            f.tries[i] = 0;
+        }
+    }
+
+    void store(uint16_t id, int y0, const uint8_t* pkt, size_t len) {
+        Frame& f = frames[id % frames.size()];
+        if (f.valid && f.frame_id == id) f.bands[y0 / lines].emplace_back(pkt, pkt + len);
+    }
+
+    // 把 NACK 要的 band 放进 out
+    void onNack(uint16_t id, const NackRange* r, int n, std::vector<const std::vector<uint8_t>*>& out) {
+        nacks++;
+        Frame& f = frames[id % frames.size()];
+        if (!f.valid || f.frame_id != id) {
+            expired++;
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            if (r[i].lines == 0) continue;
+            size_t last = std::min((size_t)(r[i].y0 + r[i].lines - 1) / lines, f.bands.size() - 1);
+            for (size_t b = r[i].y0 / lines; b <= last; b++) {
+                if (f.bands[b].empty() || f.tries[b] >= RETX_MAX_TRIES) continue;
+                f.tries[b]++;
+                for (const std::vector<uint8_t>& p : f.bands[b]) out.push_back(&p);
+            }
+        }
+    }
+};
+
+// ================= 发包和限速 =================
+struct PacketSender {
+    typedef std::chrono::steady_clock clock;
+
+    int sock;
+    struct sockaddr_in addr;
+    bool paced;
+    clock::duration interval;
+    double rate; // >0 时按字节数算下一个包的时间
+    clock::time_point next;
+    uint64_t sent = 0, bytes = 0, errors = 0, lost = 0;
+    double loss = 0;
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> coin;
+    double reorder = 0;
+    std::vector<uint8_t> held; // 模拟乱序时推迟的包
+    RateController* ctl = nullptr;
+    RetransmitWindow* window = nullptr;
+    std::vector<const std::vector<uint8_t>*> resend;
+    std::vector<uint8_t> retxPkt;
+
+    // 把排队的反馈包收完：统计包按最新的包速改包间隔，NACK 包把要的 band 重发
+    void pollFeedback() {
+        uint8_t buf[NACK_HEADER_BYTES + 2 * BAND_NACK_MAX_RANGES];
+        int n;
+        resend.clear();
+        while ((n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            FeedbackStats s;
+            NackRange r[BAND_NACK_MAX_RANGES];
+            uint16_t id;
+            int ranges;
+            if (ctl && band_parse_feedback_stats(buf, n, s)) {
+                interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / ctl->onFeedback(s)));
+            } else if (window && (ranges = band_parse_nack(buf, n, id, r)) >= 0) {
+                window->onNack(id, r, ranges, resend);
+            }
+        }
+        for (const std::vector<uint8_t>* p : resend) {
+            retxPkt = *p;
+            band_mark_retx(retxPkt.data());
+            window->resent++;
+            window->resentBytes += retxPkt.size();
+            transmit(retxPkt.data(), retxPkt.size());
+        }
+    }
+
+    void send(const uint8_t* pkt, size_t len) {
+        // 统计反馈 100ms 才一个，每 16 个包看一次就够；NACK 要尽快重发，不然重发的 band 赶不上这一帧
+        if (window || (ctl && (sent & 15) == 0)) pollFeedback();
+        transmit(pkt, len);
+    }
+
+    void transmit(const uint8_t* pkt, size_t len) {
+        if (paced) {
+            next += rate > 0 ? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(len / rate))
+                             : interval;
+            std::this_thread::sleep_until(next);
+        }
+        if (loss > 0 && coin(rng) < loss) {
+            lost++;
+            return;
+        }
+        if (reorder > 0 && held.empty() && coin(rng) < reorder) {
+            held.assign(pkt, pkt + len);
+            return;
+        }
+        wire(pkt, len);
+        if (!held.empty()) {
+            wire(held.data(), held.size());
+            held.clear();
+        }
+    }
+
+    void wire(const uint8_t* pkt, size_t len) {
+        if (sendto(sock, pkt, len, 0, (struct sockaddr*)&addr, sizeof(addr)) == (ssize_t)len) {
+            sent++;
+            bytes += len;
+        } else {
+            errors++;
+        }
+    }
+};
+
+// ================= 多 band 包 =================
+// 同一帧相邻的 band 攒进一个 BAND_PKT_MULTI 包，再放一个就超过 limit 或者换帧了就发出去；
+// 只攒到一个 band 时按普通 band 发
+struct BandPacker {
+    size_t limit = 0;
+    std::vector<uint8_t> buf;
+    int count = 0;
+    uint16_t frame_id = 0;
+    uint64_t packets = 0, bands = 0;
+
+    // band 是完整的 band 包（5 字节头 + 负载）
+    void add(PacketSender& tx, const uint8_t* band, size_t len) {
+        uint16_t id = (band[0] << 8) | band[1];
+        size_t n = len - BAND_HEADER_BYTES;
+        if (count && (id != frame_id || count == 255 || buf.size() + MULTI_SUB_HEADER_BYTES + n > limit)) {
+            flush(tx);
+        }
+        if (!count) {
+            buf.resize(BAND_HEADER_BYTES);
+            frame_id = id;
+        }
+        size_t at = buf.size();
+        buf.resize(at + MULTI_SUB_HEADER_BYTES + n);
+        band_write_multi_sub(&buf[at], band[3], band[4], (uint16_t)n);
+        memcpy(&buf[at + MULTI_SUB_HEADER_BYTES], band + BAND_HEADER_BYTES, n);
+        count++;
+    }
+
+    void flush(PacketSender& tx) {
+        if (!count) return;
+        if (count == 1) {
+            // 子 band 头前面正好能放下 band 头：[4..8] 改成 frame_id、y0、flags
+            uint8_t y0 = buf[BAND_HEADER_BYTES], flags = buf[BAND_HEADER_BYTES + 1];
+            uint8_t* h = &buf[MULTI_SUB_HEADER_BYTES];
+            h[0] = frame_id >> 8;
+            h[1] = frame_id & 0xFF;
+            h[2] = 0;
+            h[3] = y0;
+            h[4] = flags;
+            tx.send(h, buf.size() - MULTI_SUB_HEADER_BYTES);
+        } else {
+            band_write_multi_header(buf.data(), frame_id, (uint8_t)count);
+            tx.send(buf.data(), buf.size());
+            packets++;
+            bands += count;
+        }
+        count = 0;
+    }
+};
+
+int main(int argc, char** argv) {
+    SenderOptions o;
+    if (!parseArgs(argc, argv, o)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE* fp = nullptr;
+    if (o.file && !(fp = fopen(o.file, "rb"))) {
+        perror(o.file);
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int sndbuf = 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(o.port);
+    if (inet_pton(AF_INET, o.host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "bad host %s\n", o.host);
+        return 2;
+    }
+
+    uint8_t res = o.size == 240 ? BAND_RES_240 : (o.size == 180 ? BAND_RES_180 : BAND_RES_120);
+    if (o.tileW && o.size == 180 && o.tileH % BAND_180_ROW_GROUP) {
+        // 180 纵向每 3 行放大成 4 行，瓦片要按 3 行对齐才和 band 放大到同样的屏幕行，接收端不收没对齐的
+        int h = o.tileH + BAND_180_ROW_GROUP - o.tileH % BAND_180_ROW_GROUP;
+        fprintf(stderr, "tile height %d is not a multiple of %d at 180, using %d\n", o.tileH, BAND_180_ROW_GROUP, h);
+        o.tileH = h;
+    }
+    int bpp = band_bytes_per_px(o.color);
+    size_t maxPacket = o.tileW ? TILE_HEADER_BYTES + (size_t)o.tileW * o.tileH * bpp
+                               : BAND_HEADER_BYTES + (size_t)o.size * o.lines * bpp;
+    if (o.frag) maxPacket = std::min(maxPacket - BAND_HEADER_BYTES + FRAG_HEADER_BYTES, (size_t)o.frag);
+    // 编码时的缓冲区按最坏情况开
+    size_t encBound = o.codec ? BAND_HEADER_BYTES + 1 + band_encode_bound(o.codec, o.color, o.size * o.lines) : 0;
+    // 没有跨 band 状态的编码压缩后更大就发原始 band，线上的包不会比原始 band 大
+    // JPEG 超过原始 band 的大小时也改发原始 band
+    if (o.codec && !band_codec_stateless(o.codec) && o.codec != BAND_CODEC_JPEG) {
+        if (band_codec_palette(o.codec)) encBound = std::max(encBound, (size_t)BAND_HEADER_BYTES + 256 * 2);
+        if (o.codec == BAND_CODEC_YUV420) encBound = BAND_HEADER_BYTES + 1 + band_yuv420_bytes(o.size, o.lines);
+        maxPacket = encBound;
+        // 接收端把负载收进一个槽位，最坏情况也要放得下
+        if (maxPacket - BAND_HEADER_BYTES > 240 * 8 * 2) {
+            fprintf(stderr, "compressed bands can reach %zu bytes, larger than one receiver slot (3840 bytes), use fewer lines\n",
+                    maxPacket - BAND_HEADER_BYTES);
+            return 2;
+        }
+    }
+    if (o.codec == BAND_CODEC_JPEG && scale_dst_h(res, o.lines) > 8) {
+        fprintf(stderr, "jpeg bands of %d lines become %d panel lines, more than one receiver slot (8 lines)\n",
+                o.lines, scale_dst_h(res, o.lines));
+        return 2;
+    }
+    if (o.pack && o.pack < (int)maxPacket + MULTI_SUB_HEADER_BYTES) {
+        fprintf(stderr, "note: bands can reach %zu bytes, --pack %d will send those on their own\n", maxPacket, o.pack);
+    }
+    if (o.codec == BAND_CODEC_JPEG) maxPacket = std::min(maxPacket, (size_t)UDP_MTU_PAYLOAD);
+    if (maxPacket > UDP_MTU_PAYLOAD || o.pack > UDP_MTU_PAYLOAD) {
+        fprintf(stderr, "warning: %zu byte packets exceed one 1500 MTU frame, they will be IP-fragmented\n",
+                std::max(maxPacket, (size_t)o.pack));
+    }
+    if (o.tileW) {
+        // 放大后要放得进接收端的一个槽位(240x8x2 字节)
+        int dw = scale_dst_x(res, o.tileW), dh = scale_dst_h(res, o.tileH);
+        if (dw * dh * 2 > 240 * 8 * 2) {
+            fprintf(stderr, "tile %dx%d becomes %dx%d on the panel, larger than one receiver slot (3840 bytes)\n",
+                    o.tileW, o.tileH, dw, dh);
+            return 2;
+        }
+    }
+    if (o.fec && maxPacket - BAND_HEADER_BYTES > 240 * 8 * 2) {
+        // 接收端的累加器也是一个槽位大小
+        fprintf(stderr, "bands can reach %zu bytes, too large for --fec (3840 bytes max)\n", maxPacket - BAND_HEADER_BYTES);
+        return 2;
+    }
+    std::vector<uint8_t> rgb((size_t)o.size * o.size * 3);
+    std::vector<uint8_t> prev;
+    std::vector<uint8_t> pkt(maxPacket > encBound ? maxPacket : encBound);
+    // 压缩时发送端记一份接收端的参考帧（线上字节），和 band 原始字节
+    std::vector<uint8_t> ref(o.codec ? (size_t)o.size * o.size * bpp : 0);
+    std::vector<uint8_t> raw(o.codec || o.frag ? (size_t)o.size * o.lines * bpp : 0);
+    // 调色板编码器里有 128KB 的映射缓存，放堆上
+    std::unique_ptr<PaletteEncoder> palette(band_codec_palette(o.codec) ? new PaletteEncoder() : nullptr);
+    // 当前校验组：负载异或、最长负载、组里 band 数
+    std::vector<uint8_t> parity(o.fec ? PARITY_HEADER_BYTES + 240 * 8 * 2 : 0);
+    ParityHeader par = ParityHeader();
+    size_t parityLen = 0;
+
+    typedef std::chrono::steady_clock clock;
+    PacketSender tx;
+    tx.sock = sock;
+    tx.addr = addr;
+    tx.paced = o.interval > 0 || o.rate > 0;
+    tx.rate = o.rate;
+    tx.loss = o.loss;
+    tx.rng.seed(o.seed);
+    tx.reorder = o.reorder;
+    RetransmitWindow window;
+    if (o.nack) {
+        window.begin(o.nack, o.size, o.lines);
+        tx.window = &window;
+    }
+    BandPacker packer;
+    packer.limit = o.pack;
+    uint64_t fragBands = 0, fragPackets = 0;
+    uint64_t jpegRawBands = 0, jpegRawPackets = 0;
+    // JPEG 改发原始 band 时一个包放几行：不超过一个 MTU，180 时按 3 行对齐
+    int jpegRawLines = o.lines;
+    if (o.codec == BAND_CODEC_JPEG && BAND_HEADER_BYTES + (size_t)o.size * o.lines * bpp > UDP_MTU_PAYLOAD) {
+        jpegRawLines = (UDP_MTU_PAYLOAD - BAND_HEADER_BYTES) / (o.size * bpp);
+        if (o.size == 180 && jpegRawLines >= BAND_180_ROW_GROUP) jpegRawLines -= jpegRawLines % BAND_180_ROW_GROUP;
+    }
+    // pkt 里的一个 band：拼包或者直接发，开了 NACK 时记进重发窗口
+    auto sendBand = [&](uint16_t frame_id, int y0, size_t len) {
+        if (o.pack) packer.add(tx, pkt.data(), len);
+        else tx.send(pkt.data(), len);
+        if (tx.window) window.store(frame_id, y0, pkt.data(), len);
+    };
+    RateController aimd;
+    if (o.aimdMax > 0) {
+        if (o.interval <= 0) o.interval = 1.0 / 1000;
+        aimd.pps = std::min(1.0 / o.interval, o.aimdMax);
+        aimd.maxPps = o.aimdMax;
+        aimd.step = o.aimdStep;
+        o.interval = 1.0 / aimd.pps;
+        tx.paced = true;
+        tx.ctl = &aimd;
+    }
+    tx.interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(o.interval));
+    auto start = clock::now();
+    tx.next = start;
+    auto lastPrint = start;
+    uint64_t lastSent = 0, lastBytes = 0;
+    uint32_t frames = 0;
+
+    for (uint32_t frame = 0; o.frames == 0 || frame < (uint32_t)o.frames; frame++) {
+        if (o.seconds > 0 && std::chrono::duration<double>(clock::now() - start).count() >= o.seconds) break;
+        if (fp) {
+            if (!fileFrame(fp, rgb.data(), o.size)) {
+                fprintf(stderr, "%s is shorter than one %dx%d frame\n", o.file, o.size, o.size);
+                return 1;
+            }
+        } else if (o.noise) {
+            noiseFrame(rgb.data(), o.size, frame);
+        } else if (o.desktop) {
+            desktopFrame(rgb.data(), o.size, frame);
+        } else {
+            syntheticFrame(rgb.data(), o.size, frame);
+        }
+        frames++;
+
+        if (o.tileW) {
+            // 只发和上一帧不同的瓦片，第一帧全发
+            for (int y = 0; y < o.size; y += o.tileH) {
+                for (int x = 0; x < o.size; x += o.tileW) {
+                    TileHeader t;
+                    t.frame_id = frame & 0xFFFF;
+                    t.res = res;
+                    t.color = o.color;
+                    t.x = x;
+                    t.y = y;
+                    t.w = x + o.tileW <= o.size ? o.tileW : o.size - x;
+                    t.h = y + o.tileH <= o.size ? o.tileH : o.size - y;
+                    if (!prev.empty() && !rectChanged(rgb.data(), prev.data(), o.size, x, y, t.w, t.h)) continue;
+                    band_write_tile_header(pkt.data(), t);
+                    size_t len = TILE_HEADER_BYTES +
+                                 encodeRect(rgb.data(), o.size, x, y, t.w, t.h, o.color, pkt.data() + TILE_HEADER_BYTES);
+                    tx.send(pkt.data(), len);
+                }
+            }
+            prev = rgb;
+        } else {
+            if (palette) {
+                // 每帧先发这一帧的调色板，内容没变时版本号不变，接收端丢了这个包也能用旧的
+                palette->build(rgb.data(), o.size * o.size, o.codec == BAND_CODEC_PAL4 ? 16 : 256);
+                PaletteHeader ph;
+                ph.frame_id = frame & 0xFFFF;
+                ph.entries = palette->entries();
+                ph.version = palette->version();
+                band_write_palette_header(pkt.data(), ph);
+                tx.send(pkt.data(), BAND_HEADER_BYTES + palette->writeEntries(pkt.data() + BAND_HEADER_BYTES));
+            }
+            if (tx.window) window.startFrame(frame & 0xFFFF);
+            for (int y0 = 0; y0 < o.size; y0 += o.lines) {
+                if (o.frag) {
+                    // 整个 band 编好再按偏移切开，最后一片可能短一些
+                    FragHeader fh;
+                    fh.frame_id = frame & 0xFFFF;
+                    fh.y0 = y0;
+                    fh.lines = y0 + o.lines <= o.size ? o.lines : o.size - y0;
+                    fh.res = res;
+                    fh.color = o.color;
+                    size_t total = encodeRect(rgb.data(), o.size, 0, y0, o.size, fh.lines, o.color, raw.data());
+                    size_t chunk = o.frag - FRAG_HEADER_BYTES;
+                    fh.count = (total + chunk - 1) / chunk;
+                    for (fh.index = 0; fh.index < fh.count; fh.index++) {
+                        fh.offset = fh.index * chunk;
+                        size_t n = std::min(chunk, total - fh.offset);
+                        band_write_frag_header(pkt.data(), fh);
+                        memcpy(pkt.data() + FRAG_HEADER_BYTES, raw.data() + fh.offset, n);
+                        tx.send(pkt.data(), FRAG_HEADER_BYTES + n);
+                    }
+                    fragBands++;
+                    fragPackets += fh.count;
+                    continue;
+                }
+                BandHeader h;
+                h.frame_id = frame & 0xFFFF;
+                h.y0 = y0;
+                h.res = res;
+                h.color = o.codec ? BAND_COLOR_CODEC : o.color;
+                h.lines = y0 + o.lines <= o.size ? o.lines : o.size - y0;
+                band_write_header(pkt.data(), h);
+                size_t len;
+                if (palette) {
+                    pkt[BAND_HEADER_BYTES] = band_codec_byte(o.codec, palette->version(), false);
+                    len = BAND_HEADER_BYTES + 1 +
+                          palette->encode(rgb.data() + (size_t)y0 * o.size * 3, o.size * h.lines,
+                                          pkt.data() + BAND_HEADER_BYTES + 1);
+                } else if (o.codec == BAND_CODEC_YUV420) {
+                    pkt[BAND_HEADER_BYTES] = band_codec_byte(o.codec, 0, false);
+                    len = BAND_HEADER_BYTES + 1 +
+                          yuv420_encode(rgb.data() + (size_t)y0 * o.size * 3, o.size, h.lines,
+                                        pkt.data() + BAND_HEADER_BYTES + 1);
+                } else if (o.codec == BAND_CODEC_JPEG) {
+                    // 负载不能比原始 band 大，也不能超过一个 MTU
+                    size_t rawLen = (size_t)o.size * h.lines * bpp;
+                    size_t cap = std::min(rawLen, (size_t)UDP_MTU_PAYLOAD - BAND_HEADER_BYTES) - 1;
+                    pkt[BAND_HEADER_BYTES] = band_codec_byte(o.codec, 0, false);
+                    len = jpeg_slice_encode(rgb.data() + (size_t)y0 * o.size * 3, o.size, h.lines, o.quality,
+                                            pkt.data() + BAND_HEADER_BYTES + 1, cap);
+                    if (len == 0) {
+                        // 放不下就按 --color 发原始 band，一个包不超过 jpegRawLines 行
+                        BandHeader sub = h;
+                        sub.color = o.color;
+                        for (int y = y0; y < y0 + h.lines; y += jpegRawLines) {
+                            sub.y0 = y;
+                            sub.lines = std::min(jpegRawLines, y0 + h.lines - y);
+                            band_write_header(pkt.data(), sub);
+                            sendBand(sub.frame_id, y, BAND_HEADER_BYTES +
+                                     encodeRect(rgb.data(), o.size, 0, y, o.size, sub.lines, o.color, pkt.data() + BAND_HEADER_BYTES));
+                            jpegRawPackets++;
+                        }
+                        jpegRawBands++;
+                        continue; // 不能和 --fec 一起用，后面没有要做的
+                    }
+                    len += 1 + BAND_HEADER_BYTES;
+                } else if (o.codec) {
+                    // 关键帧按 band 错开，丢包后最多 keyInterval 帧恢复
+                    bool key = frame == 0 || (frame + y0 / o.lines) % o.keyInterval == 0;
+                    int n = o.size * h.lines;
+                    size_t rawLen = encodeRect(rgb.data(), o.size, 0, y0, o.size, h.lines, o.color, raw.data());
+                    pkt[BAND_HEADER_BYTES] = band_codec_byte(o.codec, o.color, key);
+                    len = band_encode(o.codec, raw.data(), ref.data() + (size_t)y0 * o.size * bpp, o.color, n, key,
+                                      pkt.data() + BAND_HEADER_BYTES + 1);
+                    if (band_codec_stateless(o.codec) && len + 1 >= rawLen) {
+                        h.color = o.color;
+                        band_write_header(pkt.data(), h);
+                        memcpy(pkt.data() + BAND_HEADER_BYTES, raw.data(), rawLen);
+                        len = rawLen;
+                    } else {
+                        len += 1;
+                    }
+                    len += BAND_HEADER_BYTES;
+                } else {
+                    len = BAND_HEADER_BYTES +
+                          encodeRect(rgb.data(), o.size, 0, y0, o.size, h.lines, o.color, pkt.data() + BAND_HEADER_BYTES);
+                }
+                sendBand(h.frame_id, y0, len);
+                if (o.fec) {
+                    int idx = y0 / o.lines;
+                    if (idx % o.fec == 0) {
+                        par.frame_id = h.frame_id;
+                        par.first = idx;
+                        par.k = o.fec;
+                        par.lines = o.lines;
+                        par.count = 0;
+                        par.lenXor = 0;
+                        par.flagsXor = 0;
+                        parityLen = 0;
+                    }
+                    size_t n = len - BAND_HEADER_BYTES;
+                    uint8_t* acc = parity.data() + PARITY_HEADER_BYTES;
+                    if (n > parityLen) {
+                        memset(acc + parityLen, 0, n - parityLen);
+                        parityLen = n;
+                    }
+                    for (size_t i = 0; i < n; i++) acc[i] ^= pkt[BAND_HEADER_BYTES + i];
+                    par.count++;
+                    par.lenXor ^= n;
+                    par.flagsXor ^= pkt[4];
+                    if (par.count == o.fec || y0 + o.lines >= o.size) {
+                        band_write_parity_header(parity.data(), par);
+                        tx.send(parity.data(), PARITY_HEADER_BYTES + parityLen);
+                    }
+                }
+            }
+            packer.flush(tx); // 多 band 包不跨帧
+        }
+        if (!tx.paced && o.tileW) {
+            // 瓦片模式下不限速时一帧可能只有几个包，按 60fps 走，不然帧号很快就回绕了
+            std::this_thread::sleep_for(std::chrono::microseconds(16667));
+        }
+
+        auto now = clock::now();
+        double sec = std::chrono::duration<double>(now - lastPrint).count();
+        if (sec >= 1.0) {
+            printf("frame %u  pps %.0f  %.2f MB/s  errors %llu", frame,
+                   (tx.sent - lastSent) / sec, (tx.bytes - lastBytes) / sec / 1e6, (unsigned long long)tx.errors);
+            if (tx.ctl) {
+                const FeedbackStats& f = aimd.last;
+                double ms = f.interval_ms ? f.interval_ms : 1;
+                printf("  target %.0f  rx pps %.0f drops %u free %u/%u draws/s %.0f", aimd.pps,
+                       f.packets * 1000 / ms, f.drops, f.freeSlots, f.slots, f.draws * 1000 / ms);
+            }
+            printf("\n");
+            fflush(stdout);
+            lastPrint = now;
+            lastSent = tx.sent;
+            lastBytes = tx.bytes;
+        }
+    }
+
+    double total = std::chrono::duration<double>(clock::now() - start).count();
+    printf("sent %u frames, %llu packets, %llu bytes in %.2f s: %.0f pps, %.2f MB/s, %.0f bytes/frame, %llu errors\n",
+           frames, (unsigned long long)tx.sent, (unsigned long long)tx.bytes, total,
+           total > 0 ? tx.sent / total : 0.0, total > 0 ? tx.bytes / total / 1e6 : 0.0,
+           frames ? (double)tx.bytes / frames : 0.0, (unsigned long long)tx.errors);
+    if (o.loss > 0) printf("simulated loss: %llu packets not sent\n", (unsigned long long)tx.lost);
+    if (o.pack) {
+        printf("pack: %llu multi-band packets carrying %llu bands (%.1f bands/packet)\n",
+               (unsigned long long)packer.packets, (unsigned long long)packer.bands,
+               packer.packets ? (double)packer.bands / packer.packets : 0.0);
+    }
+    if (o.frag) {
+        printf("frag: %llu bands in %llu fragments (%.1f fragments/band)\n", (unsigned long long)fragBands,
+               (unsigned long long)fragPackets, fragBands ? (double)fragPackets / fragBands : 0.0);
+    }
+    if (o.codec == BAND_CODEC_JPEG) {
+        printf("jpeg: %llu bands sent raw in %llu packets of up to %d lines\n", (unsigned long long)jpegRawBands,
+               (unsigned long long)jpegRawPackets, jpegRawLines);
+    }
+    if (tx.window) {
+        printf("nack: %llu requests (%llu for frames out of the window), %llu bands resent, %llu bytes (%.2f%% of all bytes)\n",
+               (unsigned long long)window.nacks, (unsigned long long)window.expired,
+               (unsigned long long)window.resent, (unsigned long long)window.resentBytes,
+               tx.bytes ? window.resentBytes * 100.0 / tx.bytes : 0.0);
+    }
+    if (tx.ctl) {
+        printf("aimd: %llu feedback packets (%llu missed), %llu decreases, final %.0f pps\n",
+               (unsigned long long)aimd.feedbacks, (unsigned long long)aimd.missed,
+               (unsigned long long)aimd.decreases, aimd.pps);
+    }
+    close(sock);
+    if (fp) fclose(fp);
+    return 0;
+}
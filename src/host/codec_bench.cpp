@@ -0,0 +1,500 @@
+// ================= band 压缩格式的离线对比 =================
+// 不走网络：把画面按 band 切开，每种编码各编一遍、再用接收端的解码函数解一遍，
+// 对比线上字节数、解码耗时和相对 RGB888 原图的 PSNR，无损编码顺便检查解出来的像素和不压缩时转换的结果一样。
+// 180/120 时再加一列放大到屏幕上 240 宽的总耗时，调色板和 YUV 是转色和放大一起做的。
+//   pio run -e native_bench && .pio/build/native_bench/program --res 240 --color 332 --pattern desktop
+//   .pio/build/native_bench/program --file shots.rgb --frames 20    (RGB888 原始帧，和 band_sender 一样)
+//   .pio/build/native_bench/program --copies --lines 3    (不压缩的 band 从收包到 DMA 每个像素搬了几个字节)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "band_protocol.h"
+#include "band_codec.h"
+#include "frame_pool.h"
+#include "band_encoder.h"
+#include "frame_source.h"
+#include "jpeg_slice.h"
+#include "scale_function2.h"
+
+struct BenchOptions {
+    int size = 240;
+    int color = BAND_COLOR_RGB332;
+    int lines = 3;
+    int frames = 200;
+    int keyInterval = 30;
+    int quality = 75;
+    double mbps = 0; // >0 时多打一列这个带宽下的帧率
+    const char* file = nullptr;
+    int pattern = 0; // 0 bar, 1 desktop, 2 noise
+    bool copies = false;
+};
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --res 240|180|120\n"
+            "  --color 565|565be|332  解码后的像素格式，默认 332\n"
+            "  --lines n        每个 band 的行数 1-8，默认 3\n"
+            "  --frames n       多少帧，默认 200\n"
+            "  --file path      RGB888 原始帧文件，不给就用生成的画面\n"
+            "  --pattern bar|desktop|noise\n"
+            "  --key-interval n XOR 关键帧间隔，默认 30\n"
+            "  --quality n      JPEG 质量，默认 75\n"
+            "  --mbps n         按这个带宽(MB/s)算每种编码能跑多少帧\n"
+            "  --copies         不比编码，数不压缩的 band 从收包到 DMA 搬了多少字节\n",
+            prog);
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--copies")) {
+            o.copies = true;
+            continue;
+        }
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) return false;
+        i++;
+        if (!strcmp(a, "--res")) o.size = atoi(v);
+        else if (!strcmp(a, "--color")) {
+            if (!strcmp(v, "565")) o.color = BAND_COLOR_RGB565;
+            else if (!strcmp(v, "565be")) o.color = BAND_COLOR_RGB565_BE;
+            else if (!strcmp(v, "332")) o.color = BAND_COLOR_RGB332;
+            else return false;
+        }
+        else if (!strcmp(a, "--lines")) o.lines = atoi(v);
+        else if (!strcmp(a, "--frames")) o.frames = atoi(v);
+        else if (!strcmp(a, "--file")) o.file = v;
+        else if (!strcmp(a, "--key-interval")) o.keyInterval = atoi(v);
+        else if (!strcmp(a, "--quality")) o.quality = atoi(v);
+        else if (!strcmp(a, "--mbps")) o.mbps = atof(v);
+        else if (!strcmp(a, "--pattern")) {
+            if (!strcmp(v, "bar")) o.pattern = 0;
+            else if (!strcmp(v, "desktop")) o.pattern = 1;
+            else if (!strcmp(v, "noise")) o.pattern = 2;
+            else return false;
+        }
+        else return false;
+    }
+    return (o.size == 240 || o.size == 180 || o.size == 120) && o.lines >= 1 &&
+           o.lines <= RGB_LINE_BATCH && o.frames > 0 && o.keyInterval > 0 && o.quality >= 1 && o.quality <= 100;
+}
+
+// ================= 每种编码 =================
+// codec 0 表示不压缩：解码就是接收端原来的转换（332 查表 / 小端翻转 / 大端直接用）
+struct BenchCodec {
+    BenchCodec(const char* name_, int codec_)
+        : name(name_), codec(codec_), bytes(0), ns(0), displayNs(0), sse(0) {
+        memset(pal, 0, sizeof(pal));
+    }
+
+    const char* name;
+    int codec;
+    uint64_t bytes;
+    double ns;
+    double displayNs;             // 180/120：从负载到 240 宽的大端像素
+    double sse;                   // 和 RGB888 原图的平方误差和
+    std::vector<uint8_t> sendRef; // XOR：发送端记的参考帧
+    std::vector<uint8_t> recvRef; // XOR：接收端的参考帧
+    std::unique_ptr<PaletteEncoder> palEnc;
+    uint16_t pal[256];            // 调色板：接收端的表，大端 RGB565
+};
+
+// 和 band_sender 一样：没有跨 band 状态的编码压缩后更大就发原始 band，isRaw 记下来
+static size_t encodeBand(BenchCodec& c, const BenchOptions& o, const uint8_t* raw, const uint8_t* rgb,
+                         int y0, int lines, uint32_t frame, uint8_t* out, bool& isRaw) {
+    int bpp = band_bytes_per_px(o.color);
+    int n = o.size * lines;
+    size_t rawLen = (size_t)n * bpp;
+    isRaw = true;
+    if (c.palEnc) {
+        isRaw = false;
+        out[0] = band_codec_byte(c.codec, c.palEnc->version(), false);
+        return 1 + c.palEnc->encode(rgb, n, out + 1);
+    }
+    if (c.codec == BAND_CODEC_YUV420) {
+        isRaw = false;
+        out[0] = band_codec_byte(c.codec, 0, false);
+        return 1 + yuv420_encode(rgb, o.size, lines, out + 1);
+    }
+    if (c.codec == BAND_CODEC_JPEG) {
+        out[0] = band_codec_byte(c.codec, 0, false);
+        size_t len = jpeg_slice_encode(rgb, o.size, lines, o.quality, out + 1, rawLen - 1);
+        if (len) {
+            isRaw = false;
+            return 1 + len;
+        }
+    }
+    if (c.codec != 0 && c.codec != BAND_CODEC_JPEG) {
+        bool key = frame == 0 || (frame + y0 / o.lines) % o.keyInterval == 0;
+        out[0] = band_codec_byte(c.codec, o.color, key);
+        size_t len = 1 + band_encode(c.codec, raw, c.sendRef.data() + (size_t)y0 * o.size * bpp, o.color, n, key, out + 1);
+        if (!band_codec_stateless(c.codec) || len < rawLen) {
+            isRaw = false;
+            return len;
+        }
+    }
+    memcpy(out, raw, rawLen);
+    return rawLen;
+}
+
+// 和 BandReceiver::decodeBand 一样，只是参考帧归 bench 管
+static bool decodeBand(BenchCodec& c, const BenchOptions& o, const uint8_t* in, size_t len, int y0, int lines,
+                       bool isRaw, uint16_t* out) {
+    int n = o.size * lines;
+    if (isRaw) {
+        if (o.color == BAND_COLOR_RGB332) {
+            rgb332_to_565be(in, out, n);
+        } else {
+            memcpy(out, in, (size_t)n * 2);
+            if (o.color == BAND_COLOR_RGB565) rgb565_to_be_inplace(out, n);
+        }
+        return true;
+    }
+    int base = in[0] & 0x03;
+    switch (c.codec) {
+    case BAND_CODEC_XOR: {
+        int bpp = band_bytes_per_px(base);
+        uint8_t* ref = c.recvRef.data() + (size_t)y0 * o.size * bpp;
+        if (in[0] & BAND_CODEC_KEY) memset(ref, 0, (size_t)n * bpp);
+        return xor_delta_decode(in + 1, len - 1, ref, base, n, out);
+    }
+    case BAND_CODEC_RLE:
+        return packbits_decode(in + 1, len - 1, base, n, out);
+    case BAND_CODEC_QOI:
+        return qoi565_decode(in + 1, len - 1, n, out);
+    case BAND_CODEC_PAL4:
+        pal4_to_565be(in + 1, c.pal, out, n);
+        return true;
+    case BAND_CODEC_PAL8:
+        pal8_to_565be(in + 1, c.pal, out, n);
+        return true;
+    case BAND_CODEC_YUV420: {
+        const uint8_t* y = in + 1;
+        const uint8_t* u = y + n;
+        yuv420_to_565be(y, u, u + (o.size / 2) * ((lines + 1) / 2), out, o.size, lines);
+        return true;
+    }
+    case BAND_CODEC_JPEG:
+        return jpeg_slice_decode(in + 1, len - 1, o.size, lines, out);
+    }
+    return false;
+}
+
+// 不压缩、调色板和 YUV 接收端直接从负载转色加放大
+static bool fusedScale(const BenchCodec& c, bool isRaw) {
+    return isRaw || band_codec_palette(c.codec) || c.codec == BAND_CODEC_YUV420;
+}
+
+// 和 BandReceiver 一样放大到 240 宽。fusedScale 的从负载直接做，其他的放大 decoded（解码出来的大端像素）
+static void scaleBand(const BenchCodec& c, const BenchOptions& o, const uint8_t* in, int lines, bool isRaw,
+                      const uint16_t* decoded, uint16_t* out) {
+    bool s180 = o.size == 180;
+    if (isRaw) {
+        if (o.color == BAND_COLOR_RGB332) {
+            if (s180) scale_180_to_240_rgb332_be(in, out, lines);
+            else scale_120_to_240_rgb332_be(in, out, lines);
+        } else if (o.color == BAND_COLOR_RGB565) {
+            if (s180) scale_180_to_240_rgb565_be((const uint16_t*)in, out, lines);
+            else scale_120_to_240_rgb565_be((const uint16_t*)in, out, lines);
+        } else {
+            if (s180) scale_180_to_240_rgb565((uint16_t*)in, out, lines);
+            else scale_120_to_240_rgb565((uint16_t*)in, out, lines);
+        }
+        return;
+    }
+    switch (c.codec) {
+    case BAND_CODEC_PAL4:
+        if (s180) scale_180_to_240_pal4_be(in + 1, c.pal, out, lines);
+        else scale_120_to_240_pal4_be(in + 1, c.pal, out, lines);
+        return;
+    case BAND_CODEC_PAL8:
+        if (s180) scale_180_to_240_pal8_be(in + 1, c.pal, out, lines);
+        else scale_120_to_240_pal8_be(in + 1, c.pal, out, lines);
+        return;
+    case BAND_CODEC_YUV420: {
+        const uint8_t* y = in + 1;
+        const uint8_t* u = y + o.size * lines;
+        const uint8_t* v = u + (o.size / 2) * ((lines + 1) / 2);
+        if (s180) scale_180_to_240_yuv420_be(y, u, v, out, lines);
+        else scale_120_to_240_yuv420_be(y, u, v, out, lines);
+        return;
+    }
+    }
+    if (s180) scale_180_to_240_rgb565((uint16_t*)decoded, out, lines);
+    else scale_120_to_240_rgb565((uint16_t*)decoded, out, lines);
+}
+
+// 解出来的大端 RGB565 按屏幕显示的样子展开成 8 位，和原图比
+static double frameSSE(const uint16_t* dec, const uint8_t* rgb, int npx) {
+    double sse = 0;
+    for (int i = 0; i < npx; i++) {
+        uint16_t v = rgb565_swap(dec[i]);
+        int r = ((v >> 11) << 3) | (v >> 13);
+        int g = (((v >> 5) & 63) << 2) | ((v >> 9) & 3);
+        int b = ((v & 31) << 3) | ((v >> 2) & 7);
+        int dr = r - rgb[i * 3], dg = g - rgb[i * 3 + 1], db = b - rgb[i * 3 + 2];
+        sse += dr * dr + dg * dg + db * db;
+    }
+    return sse;
+}
+
+static bool lossy(int codec) {
+    return band_codec_rgb(codec);
+}
+
+// ================= --copies：每个 band 搬了多少字节 =================
+// 一个不压缩的 band 从 udp.read 走到交给 DMA，CPU 每写一遍像素就记一次字节数，用的是接收端真正的转换函数。
+// old 是槽位改成 DMA 内存之前的路径：读进 1460 字节的 rxBuf，转换/拷贝进槽位，绘制线程再拷进 dmaBuf，
+//   pushImageDMA 发送前按 setSwapBytes(true) 原地翻转字节序；
+// new 是现在 BandReceiver 的路径：负载直接读进槽位，要转换的写进 spareLines 再交换指针，
+//   240 宽小端 RGB565 原地翻转，其余在转换时就写出大端，绘制线程直接拿槽位去 DMA。
+// lwIP 里的拷贝两边一样，不算。两条路径最后交给 DMA 的像素不一样就报错
+struct CopyCount {
+    uint64_t bytes = 0;
+    void copy(void* dst, const void* src, size_t n) {
+        memcpy(dst, src, n);
+        bytes += n;
+    }
+};
+
+// 一个 band 放大后的行数，和 BandReceiver 一样
+static int copyDstLines(int size, int lines) {
+    if (size == 180) return (lines * 240 + 179) / 180;
+    if (size == 120) return lines * 2;
+    return lines;
+}
+
+static bool copyPaths(int size, int color, int lines, const uint8_t* payload, double& oldPerPx, double& newPerPx) {
+    int n = size * lines;
+    size_t len = (size_t)n * band_bytes_per_px(color);
+    int dstPx = IMG_W * copyDstLines(size, lines);
+    std::vector<uint16_t> rx(SLOT_BYTES / 2), slot(SLOT_BYTES / 2), spare(SLOT_BYTES / 2), dma(SLOT_BYTES / 2);
+    bool is565 = color == BAND_COLOR_RGB565;
+
+    // ---------- old ----------
+    CopyCount old;
+    old.copy(rx.data(), payload, len);
+    const uint8_t* in8 = (const uint8_t*)rx.data();
+    if (size == 240) {
+        if (is565) {
+            old.copy(slot.data(), rx.data(), len);
+        } else {
+            for (int i = 0; i < n; i++) slot[i] = rgb332_to_565_lut[in8[i]];
+            old.bytes += (size_t)n * 2;
+        }
+    } else {
+        if (size == 180) {
+            if (is565) scale_180_to_240_rgb565(rx.data(), slot.data(), lines);
+            else scale_180_to_240_rgb332(in8, slot.data(), lines);
+        } else {
+            if (is565) scale_120_to_240_rgb565(rx.data(), slot.data(), lines);
+            else scale_120_to_240_rgb332(in8, slot.data(), lines);
+        }
+        old.bytes += (size_t)dstPx * 2;
+    }
+    old.copy(dma.data(), slot.data(), (size_t)dstPx * 2);
+    for (int i = 0; i < dstPx; i++) dma[i] = rgb565_swap(dma[i]);
+    old.bytes += (size_t)dstPx * 2;
+
+    // ---------- new ----------
+    CopyCount cur;
+    cur.copy(slot.data(), payload, len);
+    in8 = (const uint8_t*)slot.data();
+    const uint16_t* out = spare.data();
+    if (size == 240) {
+        if (is565) {
+            rgb565_to_be_inplace(slot.data(), n);
+            out = slot.data();
+        } else {
+            rgb332_to_565be(in8, spare.data(), n);
+        }
+    } else if (size == 180) {
+        if (is565) scale_180_to_240_rgb565_be(slot.data(), spare.data(), lines);
+        else scale_180_to_240_rgb332_be(in8, spare.data(), lines);
+    } else {
+        if (is565) scale_120_to_240_rgb565_be(slot.data(), spare.data(), lines);
+        else scale_120_to_240_rgb332_be(in8, spare.data(), lines);
+    }
+    cur.bytes += (size_t)dstPx * 2;
+
+    oldPerPx = (double)old.bytes / dstPx;
+    newPerPx = (double)cur.bytes / dstPx;
+    return memcmp(dma.data(), out, (size_t)dstPx * 2) == 0;
+}
+
+static int copyReport(const BenchOptions& o) {
+    init_scale_maps();
+    std::vector<uint8_t> payload(SLOT_BYTES);
+    uint32_t x = 1;
+    for (size_t i = 0; i < payload.size(); i++) {
+        x = x * 1103515245u + 12345u;
+        payload[i] = x >> 16;
+    }
+    printf("bytes written per panel pixel, udp.read -> DMA, %d lines/band (fewer where the scaled band would not fit a slot)\n",
+           o.lines);
+    printf("band      lines  old B/px  new B/px\n");
+    static const int sizes[] = {240, 180, 120};
+    static const int colors[] = {BAND_COLOR_RGB565, BAND_COLOR_RGB332};
+    bool ok = true;
+    for (int s = 0; s < 3; s++) {
+        for (int c = 0; c < 2; c++) {
+            int lines = o.lines;
+            while (copyDstLines(sizes[s], lines) > RGB_LINE_BATCH) lines--;
+            double oldPerPx, newPerPx;
+            if (!copyPaths(sizes[s], colors[c], lines, payload.data(), oldPerPx, newPerPx)) {
+                printf("MISMATCH: %d/%s old and new paths hand different pixels to DMA\n", sizes[s],
+                       colors[c] == BAND_COLOR_RGB332 ? "332" : "565");
+                ok = false;
+            }
+            printf("%3d/%-5s  %5d  %8.2f  %8.2f\n", sizes[s], colors[c] == BAND_COLOR_RGB332 ? "332" : "565",
+                   lines, oldPerPx, newPerPx);
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions o;
+    if (!parseArgs(argc, argv, o)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (o.copies) return copyReport(o);
+    FILE* fp = nullptr;
+    if (o.file && !(fp = fopen(o.file, "rb"))) {
+        perror(o.file);
+        return 1;
+    }
+
+    int bpp = band_bytes_per_px(o.color);
+    // raw 排第一个，无损编码拿它的结果当参照
+    std::vector<BenchCodec> codecs;
+    codecs.emplace_back("raw", 0);
+    codecs.emplace_back("xor", BAND_CODEC_XOR);
+    codecs.emplace_back("rle", BAND_CODEC_RLE);
+    if (o.color != BAND_COLOR_RGB332) codecs.emplace_back("qoi", BAND_CODEC_QOI);
+    codecs.emplace_back("pal4", BAND_CODEC_PAL4);
+    codecs.emplace_back("pal8", BAND_CODEC_PAL8);
+    codecs.emplace_back("yuv", BAND_CODEC_YUV420);
+    codecs.emplace_back("jpeg", BAND_CODEC_JPEG);
+    int codecCount = codecs.size();
+    for (int k = 0; k < codecCount; k++) {
+        codecs[k].sendRef.assign((size_t)o.size * o.size * bpp, 0);
+        codecs[k].recvRef.assign((size_t)o.size * o.size * bpp, 0);
+        if (band_codec_palette(codecs[k].codec)) codecs[k].palEnc.reset(new PaletteEncoder());
+    }
+
+    int bands = (o.size + o.lines - 1) / o.lines;
+    size_t bandBytes = (size_t)o.size * o.lines * bpp;
+    std::vector<uint8_t> rgb((size_t)o.size * o.size * 3);
+    std::vector<uint8_t> raw((size_t)o.size * o.size * bpp);
+    // 每个 band 的编码结果先全部编好，再整帧计时解码
+    std::vector<std::vector<uint8_t> > enc(bands, std::vector<uint8_t>(bandBytes * 3 / 2 + 1024));
+    std::vector<size_t> encLen(bands);
+    std::vector<char> encRaw(bands);
+    std::vector<uint16_t> ref((size_t)o.size * o.size);
+    std::vector<uint16_t> dec((size_t)o.size * o.size);
+    // 放大的结果只计时不比较，一个 band 最多放大成 16 行
+    std::vector<uint16_t> scaled(IMG_W * 16);
+    init_scale_maps();
+    uint64_t mismatches = 0;
+
+    typedef std::chrono::steady_clock clock;
+    for (int frame = 0; frame < o.frames; frame++) {
+        if (fp) {
+            if (!fileFrame(fp, rgb.data(), o.size)) {
+                fprintf(stderr, "%s is shorter than one %dx%d frame\n", o.file, o.size, o.size);
+                return 1;
+            }
+        } else if (o.pattern == 1) {
+            desktopFrame(rgb.data(), o.size, frame);
+        } else if (o.pattern == 2) {
+            noiseFrame(rgb.data(), o.size, frame);
+        } else {
+            syntheticFrame(rgb.data(), o.size, frame);
+        }
+        encodeRect(rgb.data(), o.size, 0, 0, o.size, o.size, o.color, raw.data());
+
+        for (int k = 0; k < codecCount; k++) {
+            BenchCodec& c = codecs[k];
+            if (c.palEnc) {
+                // 每帧一个调色板包
+                c.palEnc->build(rgb.data(), o.size * o.size, c.codec == BAND_CODEC_PAL4 ? 16 : 256);
+                uint8_t entries[512];
+                size_t n = c.palEnc->writeEntries(entries);
+                memset(c.pal, 0, sizeof(c.pal));
+                memcpy(c.pal, entries, n);
+                c.bytes += BAND_HEADER_BYTES + n;
+            }
+            for (int b = 0; b < bands; b++) {
+                int y0 = b * o.lines;
+                int lines = y0 + o.lines <= o.size ? o.lines : o.size - y0;
+                bool isRaw;
+                encLen[b] = encodeBand(c, o, raw.data() + (size_t)y0 * o.size * bpp,
+                                       rgb.data() + (size_t)y0 * o.size * 3, y0, lines, frame, enc[b].data(), isRaw);
+                encRaw[b] = isRaw;
+                c.bytes += BAND_HEADER_BYTES + encLen[b];
+            }
+            auto t0 = clock::now();
+            for (int b = 0; b < bands; b++) {
+                int y0 = b * o.lines;
+                int lines = y0 + o.lines <= o.size ? o.lines : o.size - y0;
+                if (!decodeBand(c, o, enc[b].data(), encLen[b], y0, lines, encRaw[b], dec.data() + (size_t)y0 * o.size)) {
+                    mismatches++;
+                }
+            }
+            double decodeNs = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+            c.ns += decodeNs;
+            if (o.size != IMG_W) {
+                auto t1 = clock::now();
+                for (int b = 0; b < bands; b++) {
+                    int y0 = b * o.lines;
+                    int lines = y0 + o.lines <= o.size ? o.lines : o.size - y0;
+                    scaleBand(c, o, enc[b].data(), lines, encRaw[b], dec.data() + (size_t)y0 * o.size, scaled.data());
+                }
+                c.displayNs += std::chrono::duration<double, std::nano>(clock::now() - t1).count();
+                // 先解码再放大的，两步都算；一步做完的只算放大
+                bool fused = true;
+                for (int b = 0; b < bands; b++) fused = fused && fusedScale(c, encRaw[b]);
+                if (!fused) c.displayNs += decodeNs;
+            }
+            c.sse += frameSSE(dec.data(), rgb.data(), o.size * o.size);
+            if (k == 0) {
+                ref = dec;
+            } else if (!lossy(c.codec) && dec != ref) {
+                mismatches++;
+            }
+        }
+    }
+
+    double px = (double)o.frames * o.size * o.size;
+    printf("%dx%d %s, %d lines/band, %d frames\n", o.size, o.size,
+           o.color == BAND_COLOR_RGB332 ? "332" : (o.color == BAND_COLOR_RGB565 ? "565" : "565be"),
+           o.lines, o.frames);
+    // 放大的耗时按屏幕像素算
+    double panelPx = (double)o.frames * IMG_W * IMG_W;
+    bool scaledRes = o.size != IMG_W;
+    printf("codec  bytes/frame  ratio  decode ns/px  PSNR dB%s", scaledRes ? "  to 240 ns/panel px" : "");
+    if (o.mbps > 0) printf("  fps@%4.1fMB/s", o.mbps);
+    printf("\n");
+    for (int k = 0; k < codecCount; k++) {
+        const BenchCodec& c = codecs[k];
+        double mse = c.sse / (px * 3);
+        printf("%-5s  %11.0f  %5.2f  %12.2f  %7.2f", c.name, (double)c.bytes / o.frames,
+               (double)codecs[0].bytes / c.bytes, c.ns / px, mse > 0 ? 10 * log10(255.0 * 255.0 / mse) : 99.0);
+        if (scaledRes) printf("  %19.2f", c.displayNs / panelPx);
+        if (o.mbps > 0) printf("  %13.1f", o.mbps * 1e6 * o.frames / c.bytes);
+        printf("\n");
+    }
+    if (mismatches) {
+        printf("MISMATCH: %llu decoded frames/bands differ from raw\n", (unsigned long long)mismatches);
+        return 1;
+    }
+    if (fp) fclose(fp);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "frame_source.h"
+#include <string.h>
+#include "band_protocol.h"
+
+// ================= 画面来源 =================
+// 生成的画面：渐变底色上有一条每帧移动的竖条，撕裂和丢包一眼能看出来
+void syntheticFrame(uint8_t* rgb, int size, uint32_t n) {
+    int bar = (n * 4) % size;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            uint8_t* p = rgb + (y * size + x) * 3;
+            bool on = x >= bar && x < bar + size / 16;
+            p[0] = on ? 255 : x * 255 / size;
+            p[1] = on ? 255 : y * 255 / size;
+            p[2] = on ? 255 : (uint8_t)(n * 3);
+        }
+    }
+}
+
+// 桌面类画面：大部分像素不动，只有光标和一个小窗口在变，用来看瓦片包省多少
+void desktopFrame(uint8_t* rgb, int size, uint32_t n) {
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            uint8_t* p = rgb + (y * size + x) * 3;
+            p[0] = 40 + x * 60 / size;
+            p[1] = 70 + y * 60 / size;
+            p[2] = 120;
+        }
+    }
+    // 光标每 15 帧闪一次
+    if ((n / 15) & 1) {
+        for (int y = size / 2; y < size / 2 + size / 15; y++) {
+            for (int x = size / 3; x < size / 3 + 2; x++) {
+                uint8_t* p = rgb + (y * size + x) * 3;
+                p[0] = p[1] = p[2] = 255;
+            }
+        }
+    }
+    // 小窗口来回移动
+    int bw = size / 6, bh = size / 8;
+    int span = size - bw;
+    int bx = (n * 2) % (2 * span);
+    if (bx > span) bx = 2 * span - bx;
+    int by = size / 6;
+    for (int y = by; y < by + bh; y++) {
+        for (int x = bx; x < bx + bw; x++) {
+            uint8_t* p = rgb + (y * size + x) * 3;
+            p[0] = 230;
+            p[1] = 200;
+            p[2] = 60;
+        }
+    }
+}
+
+// 随机画面：第一帧随机色块铺满，之后每帧在上一帧上随机改 1-4 个矩形，偶尔撒一把噪点。
+// 种子固定，同样的参数两次运行画面完全一样，可以拿不压缩的结果当参考
+void noiseFrame(uint8_t* rgb, int size, uint32_t n) {
+    static uint32_t seed = 12345;
+    struct Lcg {
+        uint32_t& s;
+        uint32_t next(uint32_t m) {
+            s = s * 1664525u + 1013904223u;
+            return (s >> 8) % m;
+        }
+    } r = {seed};
+    int rects = n == 0 ? 64 : 1 + r.next(4);
+    for (int k = 0; k < rects; k++) {
+        int w = 1 + r.next(n == 0 ? size : size / 4);
+        int h = 1 + r.next(n == 0 ? size : size / 4);
+        int x0 = r.next(size - w + 1), y0 = r.next(size - h + 1);
+        uint8_t c[3] = {(uint8_t)r.next(256), (uint8_t)r.next(256), (uint8_t)r.next(256)};
+        for (int y = y0; y < y0 + h; y++) {
+            for (int x = x0; x < x0 + w; x++) memcpy(rgb + (y * size + x) * 3, c, 3);
+        }
+    }
+    if (r.next(8) == 0) {
+        for (int k = 0; k < 200; k++) {
+            uint8_t* p = rgb + r.next(size * size) * 3;
+            p[0] = r.next(256);
+            p[1] = r.next(256);
+            p[2] = r.next(256);
+        }
+    }
+}
+
+bool fileFrame(FILE* fp, uint8_t* rgb, int size) {
+    size_t n = (size_t)size * size * 3;
+    if (fread(rgb, 1, n, fp) == n) return true;
+    rewind(fp);
+    return fread(rgb, 1, n, fp) == n;
+}
+
+// ================= 编码 =================
+// 一个矩形的像素按行紧排写进 out，返回字节数。band 就是 x=0、w=size 的矩形
+size_t encodeRect(const uint8_t* rgb, int size, int x, int y, int w, int h, int color, uint8_t* out) {
+    uint8_t* o = out;
+    for (int row = y; row < y + h; row++) {
+        const uint8_t* p = rgb + ((size_t)row * size + x) * 3;
+        for (int i = 0; i < w; i++, p += 3) {
+            if (color == BAND_COLOR_RGB332) {
+                *o++ = rgb888_to_332(p);
+            } else {
+                uint16_t c = rgb888_to_565(p);
+                if (color == BAND_COLOR_RGB565_BE) {
+                    *o++ = c >> 8;
+                    *o++ = c & 0xFF;
+                } else {
+                    *o++ = c & 0xFF;
+                    *o++ = c >> 8;
+                }
+            }
+        }
+    }
+    return o - out;
+}
+
+// 矩形内和上一帧有没有不同
+bool rectChanged(const uint8_t* a, const uint8_t* b, int size, int x, int y, int w, int h) {
+    for (int row = y; row < y + h; row++) {
+        size_t off = ((size_t)row * size + x) * 3;
+        if (memcmp(a + off, b + off, w * 3)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// ================= PC 工具共用的画面来源和像素编码 =================
+// rgb 都是 size*size 的 RGB888，n 是帧序号
+
+// 渐变底色上有一条每帧移动的竖条
+void syntheticFrame(uint8_t* rgb, int size, uint32_t n);
+// 静止背景 + 闪烁光标 + 移动的小窗口
+void desktopFrame(uint8_t* rgb, int size, uint32_t n);
+// 在上一帧上随机改几个矩形，种子固定，rgb 要在帧之间保留
+void noiseFrame(uint8_t* rgb, int size, uint32_t n);
+// 从 RGB888 原始帧文件读一帧，读到结尾从头循环
+bool fileFrame(FILE* fp, uint8_t* rgb, int size);
+
+static inline uint16_t rgb888_to_565(const uint8_t* p) {
+    return ((p[0] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[2] >> 3);
+}
+
+static inline uint8_t rgb888_to_332(const uint8_t* p) {
+    return (p[0] & 0xE0) | ((p[1] & 0xE0) >> 3) | (p[2] >> 6);
+}
+
+// 一个矩形按 color(BAND_COLOR_*) 编成线上的像素字节，按行紧排写进 out，返回字节数
+size_t encodeRect(const uint8_t* rgb, int size, int x, int y, int w, int h, int color, uint8_t* out);
+// 矩形内两帧有没有不同
+bool rectChanged(const uint8_t* a, const uint8_t* b, int size, int x, int y, int w, int h);
@@ -0,0 +1,365 @@
+// ================= PC 上的接收端 =================
+// 和 ESP32 用同一份收包/槽位/缩放/绘制调度代码，屏幕换成内存里的虚拟屏，
+// 用来在 Linux 上量吞吐、延迟和 SPI 总线开销。
+//   pio run -e native && .pio/build/native/program -p 8888 -t 10 --dump out.ppm
+// 也可以把收到的包录成抓包文件（--record），之后不用网络原样回放（--replay，见 band_capture.h）：
+//   .pio/build/native/program --replay captures/desktop_240_565.bcap --fast
+// 加上 --ge/--reorder/--dup/--jitter 在收包前模拟 WiFi 上的突发丢包、乱序、重复和抖动（见 impaired_transport.h），
+// 退出时的 metrics 行是完整帧、旧帧条带和延迟分位数，同一份抓包和种子下可以直接比较：
+//   .pio/build/native/program --replay captures/desktop_240_565.bcap --ge 2,30 --reorder 2,3 --jitter 5
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "socket_transport.h"
+#include "band_capture.h"
+#include "impaired_transport.h"
+#include "frame_pool.h"
+#include "band_receiver.h"
+#include "band_drawer.h"
+#include "band_feedback.h"
+#include "virtual_panel.h"
+
+#define UDP_RCVBUF (1024 * 1024)
+#define UDP_DRAIN_MAX 32
+#define DRAW_IDLE_WAIT_MS 100
+#define REPLAY_DRAIN_MS 1000 // 回放完以后最多等这么久让绘制线程画完
+
+// 收包线程提交 band 后叫醒绘制线程，相当于 ESP32 上的 xTaskNotifyGive
+static std::mutex drawMutex;
+static std::condition_variable drawCv;
+static bool drawPending = false;
+
+static void notifyDraw(void*) {
+    {
+        std::lock_guard<std::mutex> lock(drawMutex);
+        drawPending = true;
+    }
+    drawCv.notify_one();
+}
+
+// 延迟分布，单位 us
+static void printLatency(const char* name, const LatencyHist& h) {
+    printf("  %s:", name);
+    uint32_t limit = 64;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (i < LATENCY_BUCKETS - 1) printf(" <%u:%u", limit, h.b[i]);
+        else printf(" >=%u:%u", limit >> 1, h.b[i]);
+        limit <<= 1;
+    }
+    printf("\n");
+}
+
+// 绘制线程交上来的延迟样本，总结那一行按这些算精确的分位数。绘制线程停了以后才读
+static std::vector<uint32_t> latencySamples[2];
+
+static void collectSample(void* user, int kind, uint32_t us) {
+    (void)user;
+    latencySamples[kind].push_back(us);
+}
+
+// 第 q 分位（0~1），取最近的那个样本，没有样本返回 0
+static uint32_t percentile(std::vector<uint32_t>& v, double q) {
+    if (v.empty()) return 0;
+    size_t k = (size_t)(q * (v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [-p port] [-t seconds] [--spi-hz hz] [--depth n] [--present fraction] [--deadline-ms ms] [--feedback ms] [--nack ms] [--big-slots n]\n"
+            "          [--record out.bcap | --replay in.bcap [--fast]]\n"
+            "          [--ge p,r[,bad[,good]]] [--reorder pct[,depth]] [--dup pct] [--delay ms] [--jitter ms] [--seed n] [--dump out.ppm]\n"
+            "  -p        UDP 端口，默认 8888\n"
+            "  -t        运行多少秒，默认一直运行\n"
+            "  --spi-hz  模拟的 SPI 时钟，默认 60000000，0 表示发送不花时间\n"
+            "  --depth   DMA 队列深度，默认 8\n"
+            "  --present 整帧模式，收到这么多比例的行(0~1]才显示，默认 0 = 流式\n"
+            "  --deadline-ms 整帧模式下一帧最多等多久，默认 50\n"
+            "  --no-evict 不丢弃/回收过期帧的 band\n"
+            "  --feedback 每隔多少毫秒给发送端发一个反馈包，默认 100，0 表示不发\n"
+            "  --nack    当前帧缺的行等多少毫秒还没到就请发送端重发，默认 0 = 不发\n"
+            "  --big-slots 收分片大 band 用的 32 行大槽位个数，默认也是最多 4 个\n"
+            "  --record  收到的数据报原样录进抓包文件\n"
+            "  --replay  不收网络，按抓包文件里的时间间隔回放，放完就退出\n"
+            "  --fast    回放时不按时间间隔，绘制线程一腾出槽位就放下一个包，量整条流水线最快能跑多快；\n"
+            "            再加 --no-evict 每次画出来的结果都一样\n"
+            "  --ge      Gilbert-Elliott 突发丢包，百分比：好→坏 p、坏→好 r，坏/好状态下的丢包率默认 100/0\n"
+            "  --reorder 按百分比把包推迟到后面 depth 个包之后（默认 3 个）\n"
+            "  --dup     按百分比重复包\n"
+            "  --delay   每个包固定延迟多少毫秒\n"
+            "  --jitter  每个包再随机延迟 0~ms 毫秒\n"
+            "  --seed    损伤的随机种子，默认 1\n"
+            "  --dump    退出时把虚拟屏存成 PPM\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    int port = 8888;
+    int seconds = 0;
+    uint32_t spi_hz = 60000000;
+    int depth = 8;
+    const char* dump = nullptr;
+    float present = 0;
+    int deadline_ms = 50;
+    bool evict = true;
+    int feedback_ms = 100;
+    int nack_ms = 0;
+    int bigSlots = BIG_SLOT_MAX;
+    const char* record = nullptr;
+    const char* replay = nullptr;
+    bool fast = false;
+    ImpairmentProfile impair;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "-p") && v) { port = atoi(v); i++; }
+        else if (!strcmp(a, "-t") && v) { seconds = atoi(v); i++; }
+        else if (!strcmp(a, "--spi-hz") && v) { spi_hz = strtoul(v, nullptr, 10); i++; }
+        else if (!strcmp(a, "--depth") && v) { depth = atoi(v); i++; }
+        else if (!strcmp(a, "--present") && v) { present = atof(v); i++; }
+        else if (!strcmp(a, "--deadline-ms") && v) { deadline_ms = atoi(v); i++; }
+        else if (!strcmp(a, "--no-evict")) { evict = false; }
+        else if (!strcmp(a, "--feedback") && v) { feedback_ms = atoi(v); i++; }
+        else if (!strcmp(a, "--nack") && v) { nack_ms = atoi(v); i++; }
+        else if (!strcmp(a, "--big-slots") && v) { bigSlots = atoi(v); i++; }
+        else if (!strcmp(a, "--record") && v) { record = v; i++; }
+        else if (!strcmp(a, "--replay") && v) { replay = v; i++; }
+        else if (!strcmp(a, "--fast")) { fast = true; }
+        else if (!strcmp(a, "--ge") && v) {
+            double p = 0, r = 0, bad = 100, good = 0;
+            if (sscanf(v, "%lf,%lf,%lf,%lf", &p, &r, &bad, &good) < 2) { usage(argv[0]); return 2; }
+            impair.pGoodBad = p / 100;
+            impair.pBadGood = r / 100;
+            impair.lossBad = bad / 100;
+            impair.lossGood = good / 100;
+            i++;
+        }
+        else if (!strcmp(a, "--reorder") && v) {
+            double pct = 0;
+            if (sscanf(v, "%lf,%d", &pct, &impair.reorderDepth) < 1) { usage(argv[0]); return 2; }
+            impair.reorder = pct / 100;
+            i++;
+        }
+        else if (!strcmp(a, "--dup") && v) { impair.dup = atof(v) / 100; i++; }
+        else if (!strcmp(a, "--delay") && v) { impair.delay_us = atof(v) * 1000; i++; }
+        else if (!strcmp(a, "--jitter") && v) { impair.jitter_us = atof(v) * 1000; i++; }
+        else if (!strcmp(a, "--seed") && v) { impair.seed = strtoul(v, nullptr, 10); i++; }
+        else if (!strcmp(a, "--dump") && v) { dump = v; i++; }
+        else { usage(argv[0]); return 2; }
+    }
+    // 延迟和抖动按真实时间放包，不限速回放时没有意义
+    if ((record && replay) || (fast && !replay) || (fast && (impair.delay_us || impair.jitter_us))) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // 收包来源：socket，录制时套一层，回放时换成抓包文件
+    SocketTransport socketTransport(UDP_RCVBUF);
+    BandTransport* transport = &socketTransport;
+    CaptureWriter recorder;
+    CaptureReader capture;
+    std::unique_ptr<RecordingTransport> recording;
+    std::unique_ptr<ReplayTransport> replayer;
+    std::unique_ptr<ImpairedTransport> impaired;
+    if (replay) {
+        if (!capture.open(replay)) {
+            fprintf(stderr, "%s: not a capture file\n", replay);
+            return 1;
+        }
+        replayer.reset(new ReplayTransport(capture, !fast));
+        transport = replayer.get();
+    } else if (record) {
+        if (!recorder.open(record)) {
+            perror(record);
+            return 1;
+        }
+        recording.reset(new RecordingTransport(socketTransport, recorder));
+        transport = recording.get();
+    }
+    if (impair.any()) {
+        // 录制的是损伤之前的包，回放时再按同样的参数损伤
+        impaired.reset(new ImpairedTransport(*transport, impair));
+        transport = impaired.get();
+    }
+
+    FramePool pool;
+    pool.evictStale = evict;
+    BandReceiver receiver(*transport, pool);
+    VirtualPanel panel(depth, spi_hz);
+    BandDrawer drawer(pool, panel);
+    BandFeedback feedback(*transport, pool);
+    feedback.setInterval(feedback_ms);
+    receiver.nack.setDelay(nack_ms);
+
+    if (!transport->begin(port)) {
+        perror("bind");
+        return 1;
+    }
+    if (!pool.begin() || !pool.beginBig(bigSlots) || !receiver.begin()) {
+        fprintf(stderr, "alloc failed\n");
+        return 1;
+    }
+    drawer.begin();
+    if (!drawer.setPresentMode(present, deadline_ms * 1000)) {
+        fprintf(stderr, "alloc failed\n");
+        return 1;
+    }
+    receiver.setCommitHook(notifyDraw, nullptr);
+    drawer.setSampleHook(collectSample, nullptr);
+    if (replay) {
+        printf("replaying %s (%u datagrams)%s, spi %u Hz, dma depth %d\n",
+               replay, capture.count(), fast ? " as fast as possible" : "", spi_hz, depth);
+    } else {
+        printf("listening on udp %d, SO_RCVBUF %d, spi %u Hz, dma depth %d\n",
+               port, socketTransport.rcvbuf(), spi_hz, depth);
+    }
+
+    std::atomic<bool> running(true);
+    std::thread drawThread([&]() {
+        while (running.load(std::memory_order_relaxed)) {
+            if (drawer.drawOnce()) continue;
+            bool pending = drawer.idle(); // 顺便回收已经发完的槽位
+            std::unique_lock<std::mutex> lock(drawMutex);
+            drawCv.wait_for(lock, std::chrono::milliseconds(pending ? 1 : DRAW_IDLE_WAIT_MS),
+                            [] { return drawPending; });
+            drawPending = false;
+        }
+        drawer.flush(); // 最后一帧没等到下一帧开始，这里结算
+        panel.endWrite();
+    });
+
+    uint32_t start = millis();
+    uint32_t lastPrint = start;
+    uint64_t totalPackets = 0, totalBytes = 0, totalDrops = 0, totalBad = 0;
+    uint64_t totalFrames = 0, totalComplete = 0, totalRows = 0;
+    uint64_t totalStale = 0, totalRejected = 0;
+    uint64_t lastWindows = 0, lastSpi = 0;
+    DrawStats lastDraw; // 绘制线程的计数器不能在这里清零，按和上一次快照的差值算
+    // 每秒打印一次，顺便累加到总数里
+    auto report = [&](uint32_t now) {
+        double sec = now != lastPrint ? (now - lastPrint) / 1000.0 : 0.001;
+        lastPrint = now;
+
+        // 收包计数器就是这个线程写的，读完清零；绘制线程的取快照算差值
+        uint32_t packets = receiver.packets, bytes = receiver.bytes;
+        uint32_t drops = receiver.dropNoSlot, late = receiver.dropLate, bad = receiver.bad;
+        receiver.packets = 0;
+        receiver.bytes = 0;
+        receiver.dropNoSlot = 0;
+        receiver.dropLate = 0;
+        receiver.bad = 0;
+        DrawStats d;
+        drawer.snapshot(d);
+        DrawStats cur = d;
+        d.subtract(lastDraw);
+        lastDraw = cur;
+        uint32_t evicted = d.evicted;
+        totalPackets += packets;
+        totalBytes += bytes;
+        totalDrops += drops + late + evicted;
+        totalBad += bad;
+        uint64_t windows = panel.windowCmds, spi = panel.spiBytes();
+
+        printf("pps %.0f  %.2f MB/s  drop(noslot %u late %u evicted %u)  bad %u  bands %u  merged %u  windows %.0f/s  spi %.2f MB/s  pkt/wake %.1f\n",
+               packets / sec, bytes / sec / 1e6, drops, late, evicted, bad, d.bands, d.mergedBands,
+               (windows - lastWindows) / sec, (spi - lastSpi) / sec / 1e6,
+               socketTransport.wakeups() ? (double)socketTransport.datagrams() / socketTransport.wakeups() : 0.0);
+        lastWindows = windows;
+        lastSpi = spi;
+
+        // 每帧完整度：收到的行数 / 240
+        printf("  frames %u  complete %u  completeness %.1f%%  stale stripes %u  late bands %u  rejected %u\n",
+               d.frames, d.completeFrames,
+               d.frames ? d.rowsSum * 100.0 / (d.frames * IMG_H) : 0.0, d.staleStripes, d.lateBands, d.rejected);
+        totalFrames += d.frames;
+        totalComplete += d.completeFrames;
+        totalRows += d.rowsSum;
+        totalStale += d.staleStripes;
+        totalRejected += d.rejected;
+        printLatency("commit->dma", d.latency);
+        printLatency("present", d.presentLatency);
+        fflush(stdout);
+    };
+    // 回放时放完、损伤层里压着的包也放完才退出
+    auto replayDone = [&]() { return replayer && replayer->done() && (!impaired || impaired->pending() == 0); };
+    while ((seconds == 0 || millis() - start < (uint32_t)seconds * 1000) && !replayDone()) {
+        if (transport->wait(nack_ms ? nack_ms : 100)) {
+            for (int i = 0; i < UDP_DRAIN_MAX; i++) {
+                // 不限速回放时等绘制线程腾出槽位再放，不然包都丢在没有槽位上。绘制线程卡住了就照常丢
+                for (uint32_t t = millis(); fast && !pool.canAcquire() && millis() - t < DRAW_IDLE_WAIT_MS;) {
+                    std::this_thread::yield();
+                }
+                if (!receiver.poll()) break;
+            }
+        }
+        uint32_t now = millis();
+        feedback.tick(now, receiver.packetsTotal, receiver.dropsTotal + drawer.evicted, drawer.bands);
+        receiver.nack.tick(now);
+        receiver.reasm.tick(now);
+        if (now - lastPrint < 1000) continue;
+        report(now);
+    }
+
+    if (replayer) {
+        // 放完了，等就绪队列画完再停，最后几个 band 也算进去
+        for (uint32_t t = millis(); pool.readyCount() > 0 && millis() - t < REPLAY_DRAIN_MS;) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    double elapsed = (millis() - start) / 1000.0;
+    running = false;
+    notifyDraw(nullptr);
+    drawThread.join();
+    report(millis()); // 最后不满一秒的那一段，包括 flush 结算的最后一帧
+
+    printf("total: packets %llu  bytes %llu  drop %llu  bad %llu  frames %llu  complete %llu  windows %llu  spi bytes %llu"
+           "  rows %.2f%%  rejected %llu  multi %u (%u bands)  frags %u (%u bands, %u timed out, %u no slot)  palettes %u  no palette %u  fec parity %u recovered %u lost %u  feedback %u"
+           "  nack %u rows %u retx %u too late %u  dup dropped %u\n",
+           (unsigned long long)totalPackets, (unsigned long long)totalBytes,
+           (unsigned long long)totalDrops, (unsigned long long)totalBad,
+           (unsigned long long)totalFrames, (unsigned long long)totalComplete,
+           (unsigned long long)panel.windowCmds, (unsigned long long)panel.spiBytes(),
+           totalFrames ? totalRows * 100.0 / (totalFrames * IMG_H) : 0.0, (unsigned long long)totalRejected,
+           receiver.multis, receiver.multiBands,
+           receiver.frags, receiver.reasm.bands, receiver.reasm.timeouts, receiver.reasm.noSlot, receiver.palettes, receiver.dropNoPalette,
+           receiver.fec.parities, receiver.fec.recovered, receiver.fec.unrecoverable, feedback.sent,
+           receiver.nack.nacks, receiver.nack.nackRows, receiver.retx, receiver.dropRetx, receiver.dropDup);
+    printf("metrics: frames %llu  complete %llu (%.1f%%)  stale stripes %llu (%.2f/frame)"
+           "  commit->dma p50/p90/p99 %u/%u/%u us  present p50/p90/p99 %u/%u/%u us\n",
+           (unsigned long long)totalFrames, (unsigned long long)totalComplete,
+           totalFrames ? totalComplete * 100.0 / totalFrames : 0.0,
+           (unsigned long long)totalStale, totalFrames ? (double)totalStale / totalFrames : 0.0,
+           percentile(latencySamples[DRAW_SAMPLE_LATENCY], 0.5), percentile(latencySamples[DRAW_SAMPLE_LATENCY], 0.9),
+           percentile(latencySamples[DRAW_SAMPLE_LATENCY], 0.99),
+           percentile(latencySamples[DRAW_SAMPLE_PRESENT], 0.5), percentile(latencySamples[DRAW_SAMPLE_PRESENT], 0.9),
+           percentile(latencySamples[DRAW_SAMPLE_PRESENT], 0.99));
+    if (impaired) {
+        printf("impair: received %u  lost %u (%u bursts)  duplicated %u  reordered %u  delivered %u\n",
+               impaired->received, impaired->lost, impaired->bursts, impaired->duplicated,
+               impaired->reordered, impaired->delivered);
+    }
+    if (replayer) {
+        printf("replay: %u datagrams in %.3f s, %.0f pps\n", replayer->replayed, elapsed,
+               elapsed > 0 ? replayer->replayed / elapsed : 0.0);
+    }
+    if (recording) {
+        if (!recorder.close()) {
+            perror(record);
+            return 1;
+        }
+        printf("recorded %u datagrams to %s\n", recorder.count(), record);
+    }
+    if (dump && !panel.savePPM(dump)) {
+        perror(dump);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "impaired_transport.h"
+#include <string.h>
+#include "platform.h"
+
+ImpairedTransport::ImpairedTransport(BandTransport& inner, const ImpairmentProfile& profile)
+    : received(0), lost(0), bursts(0), duplicated(0), reordered(0), delivered(0),
+      inner_(inner), p_(profile), rng_(profile.seed), uniform_(0.0, 1.0), bad_(false) {}
+
+void ImpairedTransport::enqueue(const uint8_t* data, size_t len, int hold) {
+    Pending pk;
+    pk.release_us = micros() + p_.delay_us + (p_.jitter_us ? (uint32_t)(uniform_(rng_) * p_.jitter_us) : 0);
+    pk.hold = hold;
+    pk.data.assign(data, data + len);
+    q_.push_back(std::move(pk));
+}
+
+// 把里面的 transport 现在能收的包都收进来，按顺序决定每个包的命运
+void ImpairedTransport::pull() {
+    while (q_.size() < IMPAIR_QUEUE_MAX) {
+        bool truncated = false;
+        int n = inner_.recv(buf_, 0, buf_, sizeof(buf_), &truncated);
+        if (n <= 0) return;
+        received++;
+
+        if (bad_ ? coin(p_.pBadGood) : coin(p_.pGoodBad)) {
+            bad_ = !bad_;
+            if (bad_) bursts++;
+        }
+        if (coin(bad_ ? p_.lossBad : p_.lossGood)) {
+            lost++;
+            continue;
+        }
+        int hold = 0;
+        if (p_.reorderDepth > 0 && coin(p_.reorder)) {
+            hold = p_.reorderDepth;
+            reordered++;
+        }
+        enqueue(buf_, n, hold);
+        if (coin(p_.dup)) {
+            duplicated++;
+            enqueue(buf_, n, 0);
+        }
+    }
+}
+
+int ImpairedTransport::nextDue(uint32_t now, uint32_t* wait_us) const {
+    int best = -1;
+    uint32_t soonest = UINT32_MAX;
+    for (size_t i = 0; i < q_.size(); i++) {
+        const Pending& pk = q_[i];
+        int32_t left = (int32_t)(pk.release_us - now);
+        if (pk.hold > 0) {
+            // 压着的包等后面的包先走，一直没有就到点放掉
+            int32_t flush = left + IMPAIR_HOLD_MAX_US;
+            if (flush > 0) {
+                if ((uint32_t)flush < soonest) soonest = flush;
+                continue;
+            }
+            left = 0;
+        }
+        if (left > 0) {
+            if ((uint32_t)left < soonest) soonest = left;
+            continue;
+        }
+        // 到点的包里先放时间最早的
+        if (best < 0 || (int32_t)(pk.release_us - q_[best].release_us) < 0) best = (int)i;
+    }
+    if (wait_us) *wait_us = best >= 0 ? 0 : soonest;
+    return best;
+}
+
+bool ImpairedTransport::wait(uint32_t timeout_ms) {
+    uint32_t start = millis();
+    for (;;) {
+        pull();
+        uint32_t wait_us;
+        if (nextDue(micros(), &wait_us) >= 0) return true;
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= timeout_ms) return false;
+        uint32_t ms = timeout_ms - elapsed;
+        if (wait_us != UINT32_MAX && (wait_us + 999) / 1000 < ms) ms = (wait_us + 999) / 1000;
+        inner_.wait(ms ? ms : 1); // 里面来了新包也会提前醒，回去再收
+    }
+}
+
+int ImpairedTransport::recv(uint8_t* hdr, size_t hdr_len,
+                            uint8_t* payload, size_t payload_cap, bool* truncated) {
+    pull();
+    int i = nextDue(micros(), nullptr);
+    if (i < 0) return 0;
+    Pending& pk = q_[i];
+    size_t len = pk.data.size();
+    size_t h = len < hdr_len ? len : hdr_len;
+    memcpy(hdr, pk.data.data(), h);
+    size_t rest = len - h;
+    if (rest > payload_cap) {
+        rest = payload_cap;
+        *truncated = true;
+    }
+    memcpy(payload, pk.data.data() + h, rest);
+    if (pk.hold == 0) {
+        // 正常放出一个包，压着的包往前挪一格
+        for (size_t j = 0; j < q_.size(); j++) {
+            if (q_[j].hold > 0) q_[j].hold--;
+        }
+    }
+    q_.erase(q_.begin() + i);
+    delivered++;
+    return (int)len;
+}
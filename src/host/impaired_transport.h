@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <random>
+#include <vector>
+#include "band_transport.h"
+
+#define IMPAIR_QUEUE_MAX 1024    // 排着队的包最多这么多，满了就先不从里面的 transport 收
+#define IMPAIR_HOLD_MAX_US 50000 // 推迟的包后面一直没有包来时，最多压这么久
+#define IMPAIR_MAX_DATAGRAM 65535
+
+// 网络损伤参数，概率都是 0-1
+struct ImpairmentProfile {
+    // Gilbert–Elliott 突发丢包：好/坏两个状态，每个包先按概率换状态，再按所在状态的丢包率丢。
+    // 平均丢包率 = (pGoodBad * lossBad + pBadGood * lossGood) / (pGoodBad + pBadGood)，平均突发长度约 1 / pBadGood
+    double pGoodBad = 0;
+    double pBadGood = 1;
+    double lossGood = 0;
+    double lossBad = 1;
+    double reorder = 0;       // 被选中的包推迟到后面 reorderDepth 个包之后
+    int reorderDepth = 3;
+    double dup = 0;           // 重复一份，副本单独算延迟
+    uint32_t delay_us = 0;    // 固定延迟
+    uint32_t jitter_us = 0;   // 再加 [0, jitter) 的均匀随机延迟，间隔比抖动小的包之间也会乱序
+    unsigned seed = 1;        // 同一个种子、同样的输入，丢/重复/推迟的是同样的包
+
+    bool any() const {
+        return pGoodBad > 0 || lossGood > 0 || reorder > 0 || dup > 0 || delay_us > 0 || jitter_us > 0;
+    }
+};
+
+// ================= 模拟网络损伤 =================
+// 套在别的 transport 外面（socket 或者回放文件），收进来的包按 ImpairmentProfile 丢、重复、推迟、乱序以后再交给收包循环，
+// 在 PC 上复现拥挤的 2.4GHz WiFi。丢包/重复/乱序的决定只取决于种子和包的顺序，
+// 配合 --replay 每次跑的是同一个损伤序列，可以用来比较缓冲策略的改动。
+// 延迟按 wait 的毫秒粒度放包，不适合模拟亚毫秒的抖动
+class ImpairedTransport : public BandTransport {
+public:
+    ImpairedTransport(BandTransport& inner, const ImpairmentProfile& profile);
+
+    bool begin(uint16_t port) override { return inner_.begin(port); }
+    void end() override { inner_.end(); }
+    bool wait(uint32_t timeout_ms) override;
+    int recv(uint8_t* hdr, size_t hdr_len,
+             uint8_t* payload, size_t payload_cap, bool* truncated) override;
+    bool reply(const uint8_t* data, size_t len) override { return inner_.reply(data, len); }
+
+    // 收进来还没放出去的包
+    size_t pending() const { return q_.size(); }
+
+    // 统计
+    uint32_t received;   // 从里面的 transport 收到的包
+    uint32_t lost;       // 丢掉的
+    uint32_t bursts;     // 进入坏状态的次数
+    uint32_t duplicated; // 多出来的副本
+    uint32_t reordered;  // 被推迟到后面的包之后的
+    uint32_t delivered;  // 交给收包循环的
+
+private:
+    struct Pending {
+        uint32_t release_us; // 到这个时间才能放
+        int hold;            // 还要等后面这么多个包先放出去
+        std::vector<uint8_t> data;
+    };
+
+    void pull();
+    void enqueue(const uint8_t* data, size_t len, int hold);
+    // 下一个能放的包在 q_ 里的下标，没有返回 -1；wait_us 是最早的一个包还要等多久
+    int nextDue(uint32_t now, uint32_t* wait_us) const;
+    bool coin(double p) { return p > 0 && uniform_(rng_) < p; }
+
+    BandTransport& inner_;
+    ImpairmentProfile p_;
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> uniform_;
+    bool bad_;
+    std::vector<Pending> q_;
+    uint8_t buf_[IMPAIR_MAX_DATAGRAM];
+};
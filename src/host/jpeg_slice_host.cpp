@@ -0,0 +1,52 @@
+#include "jpeg_slice.h"
+#include <stdio.h>
+#include <setjmp.h>
+#include <vector>
+#include <jpeglib.h>
+
+// PC 上的 jpeg_slice_decode，和 ESP32 上 TJpg_Decoder 的版本输出一样的大端 RGB565
+
+// libjpeg 默认出错直接 exit，换成跳回来
+struct SliceError {
+    jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+static void sliceErrorExit(j_common_ptr cinfo) {
+    longjmp(((SliceError*)cinfo->err)->jump, 1);
+}
+
+bool jpeg_slice_decode(const uint8_t* in, uint32_t len, int w, int lines, uint16_t* out) {
+    jpeg_decompress_struct cinfo;
+    SliceError err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = sliceErrorExit;
+    err.mgr.output_message = [](j_common_ptr) {};
+    std::vector<uint8_t> row(w * 3);
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<uint8_t*>(in), len);
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK ||
+        (int)cinfo.image_width != w || (int)cinfo.image_height != lines) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+    while ((int)cinfo.output_scanline < lines) {
+        uint16_t* d = out + cinfo.output_scanline * w;
+        JSAMPROW r = row.data();
+        jpeg_read_scanlines(&cinfo, &r, 1);
+        for (int x = 0; x < w; x++) {
+            const uint8_t* p = &row[x * 3];
+            uint16_t v = ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3);
+            d[x] = (uint16_t)((v >> 8) | (v << 8));
+        }
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
@@ -0,0 +1,174 @@
+// ================= 槽位队列的双线程压测 =================
+// 不走网络也不画屏：一个线程当收包线程，acquire/acquireBig 拿槽位、写满带序号的数据再 commit；
+// 另一个线程当绘制线程，popReady/peekReady 取出来检查顺序和内容，再 release 回去。
+// 顺序乱了、内容没写完就被读到、槽位丢了或者被重复交出来都会报错退出，
+// 改 spsc_ring.h / frame_pool.h 的内存序以后跑一遍。能编 -fsanitize=thread 的话一起跑。
+//   pio run -e native_pool_stress && .pio/build/native_pool_stress/program --bands 5000000
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include "frame_pool.h"
+
+struct StressOptions {
+    uint32_t bands = 2000000;
+    int bigPercent = 5;   // 多少比例的 band 用大槽位，0 表示不用
+    int words = 64;       // 每个 band 写多少个 32 位字再提交，越多越容易暴露内存序的问题
+    bool yield = false;   // 队列空/满时让出 CPU，单核机器上要开
+};
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --bands n   一共提交多少个 band，默认 2000000\n"
+            "  --big pct   用大槽位的比例 0-100，默认 5\n"
+            "  --words n   每个 band 写多少个 32 位字，默认 64，最多写满一个槽位\n"
+            "  --yield     队列空/满时让出 CPU，单核机器上要加\n",
+            prog);
+}
+
+static bool parseArgs(int argc, char** argv, StressOptions& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--yield")) {
+            o.yield = true;
+            continue;
+        }
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) return false;
+        i++;
+        if (!strcmp(a, "--bands")) o.bands = strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--big")) o.bigPercent = atoi(v);
+        else if (!strcmp(a, "--words")) o.words = atoi(v);
+        else return false;
+    }
+    int maxWords = SLOT_BYTES / 4;
+    return o.bands > 0 && o.bigPercent >= 0 && o.bigPercent <= 100 && o.words > 0 && o.words <= maxWords;
+}
+
+// 第 seq 个 band 第 i 个字的内容
+static inline uint32_t pattern(uint32_t seq, int i) { return seq * 2654435761u + i; }
+
+static std::atomic<bool> failed(false);
+
+static void fail(const char* what, uint32_t seq, int idx) {
+    fprintf(stderr, "FAIL: %s  band %u  slot %d\n", what, seq, idx);
+    failed = true;
+}
+
+int main(int argc, char** argv) {
+    StressOptions o;
+    if (!parseArgs(argc, argv, o)) {
+        usage(argv[0]);
+        return 2;
+    }
+    FramePool pool;
+    pool.evictStale = false;
+    if (!pool.begin() || (o.bigPercent > 0 && !pool.beginBig(BIG_SLOT_MAX))) {
+        fprintf(stderr, "alloc failed\n");
+        return 1;
+    }
+
+    // 槽位被谁拿着：0 空闲，1 收包线程，2 绘制线程。同一个槽位同时出现在两边就是队列出错了
+    std::atomic<int> owner[SLOT_TOTAL];
+    for (int i = 0; i < SLOT_TOTAL; i++) owner[i] = 0;
+    uint32_t rxFull = 0, bigFull = 0, drawEmpty = 0, peeks = 0;
+
+    auto spin = [&]() {
+        if (o.yield) std::this_thread::yield();
+    };
+
+    auto started = std::chrono::steady_clock::now();
+
+    std::thread draw([&]() {
+        for (uint32_t expect = 0; expect < o.bands && !failed;) {
+            uint8_t idx;
+            if (!pool.popReady(idx)) {
+                drawEmpty++;
+                spin();
+                continue;
+            }
+            if (owner[idx].exchange(2) != 0) fail("ready slot still owned", expect, idx);
+            const FrameData& f = pool.slots[idx];
+            uint32_t seq = ((uint32_t)f.frame_id << 16) | f.y_start;
+            if (seq != expect || f.line_count != (idx >= FRAME_BUF_COUNT)) {
+                fail("out of order", expect, idx);
+            }
+            const uint32_t* w = (const uint32_t*)f.lines;
+            for (int i = 0; i < o.words; i++) {
+                if (w[i] != pattern(expect, i)) {
+                    fail("payload not visible", expect, idx);
+                    break;
+                }
+            }
+            // 后面排着的也看一眼，peek 不能看到还没发布的槽位
+            uint8_t next;
+            if (pool.peekReady(0, next)) {
+                peeks++;
+                if (owner[next].load() != 0) fail("peeked slot still owned", expect + 1, next);
+            }
+            owner[idx] = 0;
+            pool.release(idx);
+            expect++;
+        }
+    });
+
+    int big = -1; // 和 BandReceiver 一样，拿到没用上的大槽位留着下次用
+    for (uint32_t seq = 0; seq < o.bands && !failed; seq++) {
+        bool useBig = o.bigPercent > 0 && (seq * 37u) % 100 < (uint32_t)o.bigPercent;
+        FrameData* f = nullptr;
+        if (useBig) {
+            while (big < 0 && !failed) {
+                big = pool.acquireBig();
+                if (big < 0) {
+                    bigFull++;
+                    spin();
+                }
+            }
+            if (big >= 0) f = &pool.slots[big];
+        } else {
+            while (!(f = pool.acquire()) && !failed) {
+                rxFull++;
+                spin();
+            }
+        }
+        if (!f) break;
+        int idx = (int)(f - pool.slots);
+        if (owner[idx].exchange(1) != 0) fail("free slot still owned", seq, idx);
+        uint32_t* w = (uint32_t*)f->lines;
+        for (int i = 0; i < o.words; i++) w[i] = pattern(seq, i);
+        f->frame_id = seq >> 16;
+        f->y_start = seq & 0xFFFF;
+        f->line_count = useBig; // 绘制线程用来核对是从哪个队列来的
+        owner[idx] = 0;
+        if (useBig) {
+            pool.commitBig((uint8_t)big);
+            big = -1;
+        } else {
+            pool.commit();
+        }
+    }
+    draw.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    // 全部还回来以后，每个槽位正好能再拿到一次
+    int small = 0, bigBack = 0;
+    while (pool.acquire()) {
+        pool.commit();
+        uint8_t idx;
+        pool.popReady(idx);
+        small++;
+        if (small > FRAME_BUF_COUNT) break;
+    }
+    while (pool.acquireBig() >= 0) bigBack++;
+    if (small != FRAME_BUF_COUNT || bigBack != pool.bigCount()) {
+        fprintf(stderr, "FAIL: slots lost  small %d/%d  big %d/%d\n", small, FRAME_BUF_COUNT, bigBack, pool.bigCount());
+        failed = true;
+    }
+
+    printf("%u bands in %.3f s (%.0f/s)  big %d%%  rx full %u  big full %u  draw empty %u  peeks %u\n",
+           o.bands, sec, sec > 0 ? o.bands / sec : 0.0, o.bigPercent, rxFull, bigFull, drawEmpty, peeks);
+    printf(failed ? "FAIL\n" : "OK\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+// ================= 大端转色/放大函数的新旧对比 =================
+// 一个 8 行（放大后）的 band 反复转换，按屏幕像素算 ns/px：
+//   old 是小端版本的查表/放大，再加上 setSwapBytes(true) 时 pushImageDMA 发送前逐像素翻转的那一遍；
+//   new 是 scale_function2.h 里的 _be 版本，直接写出屏幕要的大端像素。
+// 每一行先检查新旧两条路径最后交给 DMA 的像素一样，不一样就报错退出。
+// PC 上的绝对数字和 ESP32 差得远，看的是比例。
+//   pio run -e native_scale_bench && .pio/build/native_scale_bench/program --rounds 20000
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "frame_pool.h"
+#include "scale_function2.h"
+
+#define BENCH_PX (IMG_W * RGB_LINE_BATCH)
+
+static uint8_t src_[SLOT_BYTES] __attribute__((aligned(4)));
+static uint16_t dst_[BENCH_PX] __attribute__((aligned(4)));
+// 像素数和行数和接收端一样是运行时的值。不加 static，免得编译器当成常数，把循环按固定次数展开、向量化
+int px_ = BENCH_PX;
+int lines180_ = 6;
+int lines120_ = 4;
+
+// TFT_eSPI pushImageDMA 在 _swapBytes 时做的那一遍
+__attribute__((noinline)) static void tft_swap(uint16_t* image, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) image[i] = image[i] << 8 | image[i] >> 8;
+}
+
+// 旧接收端 240 宽 RGB332 的查表，和 rgb332_to_565be 一样展开，只是表是小端的
+__attribute__((noinline)) static void old_rgb332_to_565(const uint8_t* src, uint16_t* dst, int n) {
+    while (n >= 4) {
+        dst[0] = rgb332_to_565_lut[src[0]];
+        dst[1] = rgb332_to_565_lut[src[1]];
+        dst[2] = rgb332_to_565_lut[src[2]];
+        dst[3] = rgb332_to_565_lut[src[3]];
+        src += 4;
+        dst += 4;
+        n   -= 4;
+    }
+    while (n--) *dst++ = rgb332_to_565_lut[*src++];
+}
+
+// ---------- 每种 band 的两条路径，都是从 src_ 转到 dst_ ----------
+// 240/565 的负载在旧接收端本来就在槽位里，只剩翻转；新的是原地翻转
+static void old_240_565() { tft_swap(dst_, px_); }
+static void new_240_565() { rgb565_to_be_inplace(dst_, px_); }
+static void old_240_332() { old_rgb332_to_565(src_, dst_, px_); tft_swap(dst_, px_); }
+static void new_240_332() { rgb332_to_565be(src_, dst_, px_); }
+static void old_180_565() { scale_180_to_240_rgb565((const uint16_t*)src_, dst_, lines180_); tft_swap(dst_, px_); }
+static void new_180_565() { scale_180_to_240_rgb565_be((const uint16_t*)src_, dst_, lines180_); }
+static void old_180_332() { scale_180_to_240_rgb332(src_, dst_, lines180_); tft_swap(dst_, px_); }
+static void new_180_332() { scale_180_to_240_rgb332_be(src_, dst_, lines180_); }
+static void old_120_565() { scale_120_to_240_rgb565((const uint16_t*)src_, dst_, lines120_); tft_swap(dst_, px_); }
+static void new_120_565() { scale_120_to_240_rgb565_be((const uint16_t*)src_, dst_, lines120_); }
+static void old_120_332() { scale_120_to_240_rgb332(src_, dst_, lines120_); tft_swap(dst_, px_); }
+static void new_120_332() { scale_120_to_240_rgb332_be(src_, dst_, lines120_); }
+
+struct KernelPair {
+    const char* name;
+    void (*oldPath)();
+    void (*newPath)();
+    bool inPlace; // 240/565：转换前先把负载放进 dst_，和槽位里的一样
+};
+
+static const KernelPair pairs[] = {
+    {"240/565", old_240_565, new_240_565, true},
+    {"240/332", old_240_332, new_240_332, false},
+    {"180/565", old_180_565, new_180_565, false},
+    {"180/332", old_180_332, new_180_332, false},
+    {"120/565", old_120_565, new_120_565, false},
+    {"120/332", old_120_332, new_120_332, false},
+};
+
+static void load(const KernelPair& k) {
+    if (k.inPlace) memcpy(dst_, src_, sizeof(dst_));
+}
+
+static double nsPerPx(const KernelPair& k, void (*fn)(), int rounds) {
+    load(k);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        fn(); // 原地翻转的每一轮翻回去又翻过来，耗时一样
+        asm volatile("" : : "r"(dst_) : "memory");
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return ns / rounds / BENCH_PX;
+}
+
+int main(int argc, char** argv) {
+    int rounds = 20000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--rounds n]   每种 band 转换多少遍，默认 20000\n", argv[0]);
+            return 2;
+        }
+    }
+    if (rounds <= 0) rounds = 1;
+    init_scale_maps();
+    uint32_t x = 1;
+    for (size_t i = 0; i < sizeof(src_); i++) {
+        x = x * 1103515245u + 12345u;
+        src_[i] = x >> 16;
+    }
+
+    static uint16_t ref[BENCH_PX];
+    printf("%d panel px per band, %d rounds\n", BENCH_PX, rounds);
+    printf("band       old ns/px  new ns/px  speedup\n");
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        const KernelPair& k = pairs[i];
+        load(k);
+        k.oldPath();
+        memcpy(ref, dst_, sizeof(ref));
+        load(k);
+        k.newPath();
+        if (memcmp(ref, dst_, sizeof(ref))) {
+            printf("MISMATCH: %s old and new paths hand different pixels to DMA\n", k.name);
+            return 1;
+        }
+        double o = nsPerPx(k, k.oldPath, rounds);
+        double n = nsPerPx(k, k.newPath, rounds);
+        printf("%-9s  %9.3f  %9.3f  %6.1fx\n", k.name, o, n, n > 0 ? o / n : 0.0);
+    }
+    // 发送端已经按大端发的 240/565 新路径什么都不用做，旧路径还是要翻转一遍
+    printf("%-9s  %9.3f  %9s\n", "240/565be", nsPerPx(pairs[0], old_240_565, rounds), "-");
+    return 0;
+}
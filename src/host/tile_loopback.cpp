@@ -0,0 +1,197 @@
+// ================= 瓦片和 band 的回环对比 =================
+// 不走网络：同一帧 180 的画面一次切成整行 band、一次切成瓦片，各自喂给一套新的
+// BandReceiver + BandDrawer + VirtualPanel，最后比较两块虚拟屏，有一个像素不一样就报错退出。
+// 还检查 180 下没按 3 行对齐的瓦片会被接收端当成坏包丢掉，不会画到屏上。
+// 改 scale_dst_* / 瓦片放大函数以后跑一遍。
+//   pio run -e native_tile_loopback && .pio/build/native_tile_loopback/program --tile 30x6
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "band_transport.h"
+#include "band_receiver.h"
+#include "band_drawer.h"
+#include "frame_pool.h"
+#include "virtual_panel.h"
+
+#define LOOP_SIZE 180
+#define LOOP_BAND_LINES 6 // 放大后正好 8 行，一个槽位
+
+// 内存里的数据报队列，push 进去的包按顺序被 recv 出来
+class MemoryTransport : public BandTransport {
+public:
+    bool begin(uint16_t port) override {
+        (void)port;
+        return true;
+    }
+    bool wait(uint32_t timeout_ms) override {
+        (void)timeout_ms;
+        return !queue_.empty();
+    }
+    int recv(uint8_t* hdr, size_t hdr_len, uint8_t* payload, size_t payload_cap, bool* truncated) override {
+        if (queue_.empty()) return 0;
+        std::vector<uint8_t> d;
+        d.swap(queue_.front());
+        queue_.pop_front();
+        size_t h = d.size() < hdr_len ? d.size() : hdr_len;
+        memcpy(hdr, d.data(), h);
+        size_t rest = d.size() - h;
+        *truncated = rest > payload_cap;
+        memcpy(payload, d.data() + h, *truncated ? payload_cap : rest);
+        return (int)d.size();
+    }
+    void push(const std::vector<uint8_t>& d) { queue_.push_back(d); }
+
+private:
+    std::deque<std::vector<uint8_t>> queue_;
+};
+
+// 一套完整的接收端，收完所有包、画完所有 band 以后屏幕内容在 panel.fb
+struct Loopback {
+    MemoryTransport transport;
+    FramePool pool;
+    BandReceiver receiver;
+    VirtualPanel panel;
+    BandDrawer drawer;
+
+    Loopback() : receiver(transport, pool), panel(8, 0), drawer(pool, panel) {}
+
+    bool begin() {
+        pool.evictStale = false;
+        if (!transport.begin(0) || !pool.begin() || !receiver.begin()) return false;
+        drawer.begin();
+        return true;
+    }
+
+    // 先画到有空槽位再收，没有槽位时 poll 会把包丢掉
+    void feed(const std::vector<uint8_t>& d) {
+        transport.push(d);
+        while (!pool.canAcquire()) {
+            if (!drawer.drawOnce()) drawer.idle();
+        }
+        receiver.poll();
+        while (drawer.drawOnce()) {}
+    }
+
+    void finish() {
+        while (drawer.idle()) {}
+        panel.endWrite();
+    }
+};
+
+static uint8_t src_[LOOP_SIZE * LOOP_SIZE]; // RGB332
+
+static std::vector<uint8_t> bandPacket(uint16_t frame_id, int y0, int lines) {
+    std::vector<uint8_t> p(BAND_HEADER_BYTES + LOOP_SIZE * lines);
+    BandHeader h;
+    h.frame_id = frame_id;
+    h.y0 = y0;
+    h.res = BAND_RES_180;
+    h.color = BAND_COLOR_RGB332;
+    h.lines = lines;
+    h.retx = false;
+    band_write_header(p.data(), h);
+    memcpy(p.data() + BAND_HEADER_BYTES, src_ + y0 * LOOP_SIZE, LOOP_SIZE * lines);
+    return p;
+}
+
+static std::vector<uint8_t> tilePacket(uint16_t frame_id, int x, int y, int w, int h) {
+    std::vector<uint8_t> p(TILE_HEADER_BYTES + w * h);
+    TileHeader t;
+    t.frame_id = frame_id;
+    t.res = BAND_RES_180;
+    t.color = BAND_COLOR_RGB332;
+    t.x = x;
+    t.y = y;
+    t.w = w;
+    t.h = h;
+    band_write_tile_header(p.data(), t);
+    for (int r = 0; r < h; r++) {
+        memcpy(p.data() + TILE_HEADER_BYTES + r * w, src_ + (y + r) * LOOP_SIZE + x, w);
+    }
+    return p;
+}
+
+// 返回第一处不一样的屏幕行，全一样返回 -1
+static int firstDiffRow(const VirtualPanel& a, const VirtualPanel& b, int* diffPx) {
+    int row = -1;
+    *diffPx = 0;
+    for (int i = 0; i < IMG_W * IMG_H; i++) {
+        if (a.fb[i] != b.fb[i]) {
+            if (row < 0) row = i / IMG_W;
+            (*diffPx)++;
+        }
+    }
+    return row;
+}
+
+int main(int argc, char** argv) {
+    int tileW = 30, tileH = 6;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--tile") && i + 1 < argc &&
+            sscanf(argv[i + 1], "%dx%d", &tileW, &tileH) == 2) {
+            i++;
+        } else {
+            fprintf(stderr, "usage: %s [--tile WxH]   180 下的瓦片尺寸，高度要是 3 的倍数，默认 30x6\n", argv[0]);
+            return 2;
+        }
+    }
+    if (tileW <= 0 || tileH <= 0 || tileW > LOOP_SIZE || tileH > LOOP_SIZE || tileH % BAND_180_ROW_GROUP ||
+        scale_dst_x(BAND_RES_180, tileW) * scale_dst_h(BAND_RES_180, tileH) > IMG_W * RGB_LINE_BATCH) {
+        fprintf(stderr, "tile %dx%d: height must be a multiple of %d and fit one slot\n", tileW, tileH, BAND_180_ROW_GROUP);
+        return 2;
+    }
+    uint32_t x = 1;
+    for (size_t i = 0; i < sizeof(src_); i++) {
+        x = x * 1103515245u + 12345u;
+        src_[i] = x >> 16;
+    }
+
+    // 发完的回调只认最后一个 begin 的 BandDrawer，两套接收端一套跑完再开下一套
+    Loopback* bands = new Loopback;
+    Loopback* tiles = new Loopback;
+    if (!bands->begin()) {
+        fprintf(stderr, "alloc failed\n");
+        return 1;
+    }
+    for (int y = 0; y < LOOP_SIZE; y += LOOP_BAND_LINES) bands->feed(bandPacket(1, y, LOOP_BAND_LINES));
+    bands->finish();
+
+    if (!tiles->begin()) {
+        fprintf(stderr, "alloc failed\n");
+        return 1;
+    }
+    int sent = 0;
+    for (int y = 0; y < LOOP_SIZE; y += tileH) {
+        for (int tx = 0; tx < LOOP_SIZE; tx += tileW) {
+            int w = tx + tileW <= LOOP_SIZE ? tileW : LOOP_SIZE - tx;
+            int h = y + tileH <= LOOP_SIZE ? tileH : LOOP_SIZE - y;
+            tiles->feed(tilePacket(1, tx, y, w, h));
+            sent++;
+        }
+    }
+    uint32_t badBefore = tiles->receiver.bad;
+    uint32_t tilesBefore = tiles->receiver.tiles;
+    // 没对齐的瓦片：4 行从第 3 行开始、3 行从第 1 行开始，都要被丢掉
+    tiles->feed(tilePacket(2, 0, 3, tileW, 4));
+    tiles->feed(tilePacket(2, 0, 1, tileW, 3));
+    tiles->finish();
+
+    bool failed = false;
+    int diffPx;
+    int row = firstDiffRow(bands->panel, tiles->panel, &diffPx);
+    if (row >= 0) {
+        printf("MISMATCH: %dx%d tiles differ from bands, first at panel row %d, %d px\n", tileW, tileH, row, diffPx);
+        failed = true;
+    }
+    if (tiles->receiver.bad - badBefore != 2 || tiles->receiver.tiles != tilesBefore) {
+        printf("FAIL: misaligned 180 tiles were not rejected (bad %u, tiles %u)\n",
+               tiles->receiver.bad - badBefore, tiles->receiver.tiles - tilesBefore);
+        failed = true;
+    }
+    printf("%d bands vs %d tiles of %dx%d at 180, panel %dx%d\n",
+           LOOP_SIZE / LOOP_BAND_LINES, sent, tileW, tileH, IMG_W, IMG_H);
+    printf(failed ? "FAIL\n" : "OK\n");
+    return failed ? 1 : 0;
+}
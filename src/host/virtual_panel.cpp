@@ -0,0 +1,132 @@
+#include "virtual_panel.h"
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+
+// CASET(1+4) + RASET(1+4) + RAMWR(1)
+#define WINDOW_CMD_BYTES 11
+
+static uint64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+VirtualPanel::VirtualPanel(uint8_t depth, uint32_t spi_hz)
+    : windowCmds(0), cmdBytes(0), pixelBytes(0), blocks(0),
+      done_(nullptr), depth_(depth > MAX_DEPTH ? MAX_DEPTH : (depth ? depth : 1)), spiHz_(spi_hz),
+      head_(0), count_(0), busyUntilUs_(0), pendingCmdBytes_(0),
+      wx_(0), wy_(0), ww_(0), wh_(0), cursor_(0) {
+    for (int i = 0; i < IMG_W * IMG_H; i++) fb[i] = 0;
+}
+
+uint64_t VirtualPanel::sendTime(uint64_t bytes) {
+    return spiHz_ ? bytes * 8 * 1000000 / spiHz_ : 0;
+}
+
+// 把 now 之前发完的块按顺序报告完成
+void VirtualPanel::reapUntil(uint64_t now_us) {
+    while (count_ && queue_[head_].done_us <= now_us) {
+        void* user = queue_[head_].user;
+        head_ = (head_ + 1) % MAX_DEPTH;
+        count_--;
+        if (done_) done_(user);
+    }
+}
+
+bool VirtualPanel::busy() {
+    reapUntil(nowUs());
+    return count_ != 0;
+}
+
+// 睡到最老的一块发完
+void VirtualPanel::waitOldest() {
+    uint64_t done = queue_[head_].done_us;
+    uint64_t now = nowUs();
+    if (done > now) {
+        std::this_thread::sleep_for(std::chrono::microseconds(done - now));
+        now = nowUs();
+    }
+    reapUntil(now > done ? now : done);
+}
+
+void VirtualPanel::endWrite() {
+    while (count_) waitOldest();
+}
+
+void VirtualPanel::writePixels(const uint16_t* buf, uint32_t len) {
+    uint32_t area = (uint32_t)ww_ * wh_;
+    for (uint32_t i = 0; i < len && cursor_ < area; i++, cursor_++) {
+        int32_t x = wx_ + cursor_ % ww_;
+        int32_t y = wy_ + cursor_ / ww_;
+        fb[y * IMG_W + x] = buf[i];
+    }
+}
+
+bool VirtualPanel::enqueue(uint16_t* buf, uint32_t len, void* user) {
+    // 队列满：等最老的一块发完
+    while (count_ >= depth_) {
+        waitOldest();
+    }
+    writePixels(buf, len);
+    pixelBytes += (uint64_t)len * 2;
+    blocks++;
+
+    uint64_t now = nowUs();
+    uint64_t start = busyUntilUs_ > now ? busyUntilUs_ : now;
+    busyUntilUs_ = start + sendTime(pendingCmdBytes_ + (uint64_t)len * 2);
+    pendingCmdBytes_ = 0;
+
+    Block& b = queue_[(head_ + count_) % MAX_DEPTH];
+    b.user = user;
+    b.done_us = busyUntilUs_;
+    count_++;
+    return true;
+}
+
+bool VirtualPanel::startWindow(int32_t x, int32_t y, int32_t w, int32_t h,
+                               uint16_t* buf, uint32_t len, void* user) {
+    if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > IMG_W || y + h > IMG_H) {
+        return false;
+    }
+    wx_ = x;
+    wy_ = y;
+    ww_ = w;
+    wh_ = h;
+    cursor_ = 0;
+    windowCmds++;
+    cmdBytes += WINDOW_CMD_BYTES;
+    pendingCmdBytes_ += WINDOW_CMD_BYTES;
+    return enqueue(buf, len, user);
+}
+
+bool VirtualPanel::pushPixels(uint16_t* buf, uint32_t len, void* user) {
+    return enqueue(buf, len, user);
+}
+
+void VirtualPanel::fillScreen(uint16_t color) {
+    endWrite();
+    // TFT_eSPI 的 fillScreen 收的是本机 RGB565，发到屏上是大端
+    uint16_t be = (uint16_t)((color >> 8) | (color << 8));
+    for (int i = 0; i < IMG_W * IMG_H; i++) fb[i] = be;
+    windowCmds++;
+    cmdBytes += WINDOW_CMD_BYTES;
+    pixelBytes += IMG_W * IMG_H * 2;
+    busyUntilUs_ = nowUs() + sendTime(WINDOW_CMD_BYTES + IMG_W * IMG_H * 2);
+}
+
+bool VirtualPanel::savePPM(const char* path) const {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+    fprintf(fp, "P6\n%d %d\n255\n", IMG_W, IMG_H);
+    for (int i = 0; i < IMG_W * IMG_H; i++) {
+        uint16_t c = (uint16_t)((fb[i] >> 8) | (fb[i] << 8)); // 大端 → 本机
+        uint8_t rgb[3] = {
+            (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+            (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+            (uint8_t)((c & 0x1F) * 255 / 31),
+        };
+        fwrite(rgb, 1, 3, fp);
+    }
+    fclose(fp);
+    return true;
+}
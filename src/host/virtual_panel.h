@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include "band_panel.h"
+#include "band_protocol.h"
+
+// ================= 内存里的 240x240 虚拟屏 =================
+// 按 ST7789 的方式接收窗口命令和大端 RGB565 像素，写进 fb。
+// 统计窗口命令数和 SPI 上实际要走的字节数，按 spi_hz 模拟 DMA 队列的发送时间，
+// 队列满时和真机一样要等最老的一块发完。spi_hz = 0 表示发送不花时间
+class VirtualPanel : public BandPanel {
+public:
+    explicit VirtualPanel(uint8_t depth = 8, uint32_t spi_hz = 60000000);
+
+    void setDoneCallback(void (*cb)(void*)) override { done_ = cb; }
+    void startWrite() override {}
+    void endWrite() override;
+    bool startWindow(int32_t x, int32_t y, int32_t w, int32_t h,
+                     uint16_t* buf, uint32_t len, void* user) override;
+    bool pushPixels(uint16_t* buf, uint32_t len, void* user) override;
+    bool busy() override;
+    uint8_t queued() override { return count_; }
+    void fillScreen(uint16_t color) override;
+
+    // 屏幕内容转成 PPM 存盘，方便肉眼或 cmp 检查
+    bool savePPM(const char* path) const;
+
+    uint16_t fb[IMG_W * IMG_H]; // 屏幕字节序(大端)，和槽位里的一样
+
+    // 统计
+    uint64_t windowCmds; // CASET+RASET+RAMWR 一组算一次
+    uint64_t cmdBytes;   // 命令和参数字节
+    uint64_t pixelBytes;
+    uint64_t blocks;     // 排队的像素块数
+    uint64_t spiBytes() const { return cmdBytes + pixelBytes; }
+
+private:
+    static const uint8_t MAX_DEPTH = 32;
+    struct Block {
+        void* user;
+        uint64_t done_us;
+    };
+
+    bool enqueue(uint16_t* buf, uint32_t len, void* user);
+    void writePixels(const uint16_t* buf, uint32_t len);
+    uint64_t sendTime(uint64_t bytes);
+    void reapUntil(uint64_t now_us);
+    void waitOldest();
+
+    void (*done_)(void*);
+    uint8_t depth_;
+    uint32_t spiHz_;
+    Block queue_[MAX_DEPTH];
+    uint8_t head_;
+    uint8_t count_;
+    uint64_t busyUntilUs_; // 总线上最后一块发完的时间
+    uint64_t pendingCmdBytes_; // 窗口命令的字节，算进下一块的发送时间
+
+    // 当前窗口和写指针
+    int32_t wx_, wy_, ww_, wh_;
+    uint32_t cursor_;
+};
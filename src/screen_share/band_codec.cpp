@@ -0,0 +1,154 @@
+#include "band_codec.h"
+#include "band_protocol.h"
+#include "scale_function2.h"
+#include <string.h>
+
+// ref 第 i 个像素转成大端 RGB565
+IRAM_ATTR static inline uint16_t ref_px_be(const uint8_t* ref, int i, int base) {
+    if (base == BAND_COLOR_RGB332) return rgb332_to_565be_lut[ref[i]];
+    uint16_t p;
+    memcpy(&p, ref + i * 2, 2);
+    return base == BAND_COLOR_RGB565 ? rgb565_swap(p) : p;
+}
+
+IRAM_ATTR bool xor_delta_decode(const uint8_t* in, uint32_t len, uint8_t* ref, int base, int n, uint16_t* out) {
+    const uint8_t* end = in + len;
+    int bpp = band_bytes_per_px(base);
+    int i = 0;
+    while (i < n) {
+        if (end - in < 2) return false;
+        int zeros = in[0];
+        int lits = in[1];
+        in += 2;
+        if (i + zeros + lits > n || end - in < lits * bpp) return false;
+
+        // 不变的像素：直接从 ref 转换，332 和 band 一样走查表，大端直接拷
+        if (base == BAND_COLOR_RGB332) {
+            rgb332_to_565be(ref + i, out + i, zeros);
+        } else if (base == BAND_COLOR_RGB565_BE) {
+            memcpy(out + i, ref + i * 2, zeros * 2);
+        } else {
+            for (int k = 0; k < zeros; k++) out[i + k] = ref_px_be(ref, i + k, base);
+        }
+        i += zeros;
+
+        // 异或值：更新 ref，顺手查表/翻转写出
+        if (bpp == 1) {
+            for (int k = 0; k < lits; k++, i++) {
+                uint8_t v = ref[i] ^= *in++;
+                out[i] = rgb332_to_565be_lut[v];
+            }
+        } else {
+            bool le = base == BAND_COLOR_RGB565;
+            for (int k = 0; k < lits; k++, i++) {
+                uint8_t b0 = ref[i * 2] ^= in[0];
+                uint8_t b1 = ref[i * 2 + 1] ^= in[1];
+                in += 2;
+                // 写成屏幕字节序：先高字节
+                uint8_t* o = (uint8_t*)(out + i);
+                o[0] = le ? b1 : b0;
+                o[1] = le ? b0 : b1;
+            }
+        }
+    }
+    return true;
+}
+
+// out 里填 n 个同样的像素，对齐后按 32 位写
+IRAM_ATTR static inline void fill_px(uint16_t* out, uint16_t v, int n) {
+    if (n > 0 && ((uintptr_t)out & 2)) {
+        *out++ = v;
+        n--;
+    }
+    uint32_t v2 = v | ((uint32_t)v << 16);
+    uint32_t* d = (uint32_t*)out;
+    while (n >= 8) {
+        d[0] = v2;
+        d[1] = v2;
+        d[2] = v2;
+        d[3] = v2;
+        d += 4;
+        n -= 8;
+    }
+    while (n >= 2) {
+        *d++ = v2;
+        n -= 2;
+    }
+    if (n) *(uint16_t*)d = v;
+}
+
+IRAM_ATTR bool packbits_decode(const uint8_t* in, uint32_t len, int base, int n, uint16_t* out) {
+    const uint8_t* end = in + len;
+    int bpp = band_bytes_per_px(base);
+    int i = 0;
+    while (i < n) {
+        if (in >= end) return false;
+        int c = *in++;
+        if (c < 128) {
+            int lits = c + 1;
+            if (i + lits > n || end - in < lits * bpp) return false;
+            if (base == BAND_COLOR_RGB332) {
+                rgb332_to_565be(in, out + i, lits);
+            } else if (base == BAND_COLOR_RGB565_BE) {
+                memcpy(out + i, in, lits * 2);
+            } else {
+                for (int k = 0; k < lits; k++) out[i + k] = (uint16_t)((in[k * 2] << 8) | in[k * 2 + 1]);
+            }
+            in += lits * bpp;
+            i += lits;
+        } else if (c > 128) {
+            int run = 257 - c;
+            if (i + run > n || end - in < bpp) return false;
+            fill_px(out + i, ref_px_be(in, 0, base), run);
+            in += bpp;
+            i += run;
+        }
+    }
+    return true;
+}
+
+// 整个循环只在寄存器里算 565 的值，写出时翻转成屏幕字节序。
+// ESP32 上每个 band 在上一个 band 的 DMA 发完之前要解完，所以每个操作只查一次边界
+IRAM_ATTR bool qoi565_decode(const uint8_t* in, uint32_t len, int n, uint16_t* out) {
+    const uint8_t* end = in + len;
+    uint16_t index[64];
+    memset(index, 0, sizeof(index));
+    uint32_t px = 0;
+    int i = 0;
+    while (i < n) {
+        if (in >= end) return false;
+        uint32_t b = *in++;
+        if (b == QOI565_OP_RGB) {
+            if (end - in < 2) return false;
+            px = (in[0] << 8) | in[1];
+            in += 2;
+            index[qoi565_hash(px)] = px;
+        } else if (b >= QOI565_OP_RUN) {
+            int run = (b & 0x3F) + 1;
+            if (i + run > n) return false;
+            fill_px(out + i, rgb565_swap(px), run);
+            i += run;
+            continue;
+        } else if (b < QOI565_OP_DIFF) {
+            px = index[b];
+        } else if (b < QOI565_OP_LUMA) {
+            uint32_t r = ((px >> 11) + ((b >> 4) & 3) - 2) & 31;
+            uint32_t g = ((px >> 5) + ((b >> 2) & 3) - 2) & 63;
+            uint32_t bl = (px + (b & 3) - 2) & 31;
+            px = (r << 11) | (g << 5) | bl;
+            index[qoi565_hash(px)] = px;
+        } else {
+            if (in >= end) return false;
+            int dg = (int)(b & 0x3F) - 32;
+            int half = dg >> 1;
+            uint32_t b2 = *in++;
+            uint32_t r = ((px >> 11) + half + (int)(b2 >> 4) - 8) & 31;
+            uint32_t g = ((px >> 5) + dg) & 63;
+            uint32_t bl = (px + half + (int)(b2 & 15) - 8) & 31;
+            px = (r << 11) | (g << 5) | bl;
+            index[qoi565_hash(px)] = px;
+        }
+        out[i++] = rgb565_swap(px);
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include "platform.h"
+
+// ================= band 压缩格式的解码 =================
+// 输出都是源分辨率的大端 RGB565，和不压缩时转换后的结果一样，后面照常放大。
+// 编码端在 src/host/band_encoder.*
+
+// ---------------- BAND_CODEC_XOR ----------------
+// 接收端按源分辨率、原始像素格式保存一整帧 ref（像素的线上字节），band 的每个像素和 ref 对应位置的像素异或。
+// 异或结果按下面的记号流编码，直到覆盖 n 个像素：
+//   [zeros:u8][lits:u8][lits 个像素]   zeros 个不变的像素，接着 lits 个异或值
+// 关键帧（BAND_CODEC_KEY）先把 ref 这一段清零，异或值就是像素本身，丢包后靠它恢复。
+// ref 就地更新，同时按 base 转成大端 RGB565 写进 out。数据不对返回 false
+bool xor_delta_decode(const uint8_t* in, uint32_t len, uint8_t* ref, int base, int n, uint16_t* out);
+
+// ---------------- BAND_CODEC_RLE ----------------
+// PackBits，以像素为单位：
+//   c = 0..127    后面 c+1 个原样的像素
+//   c = 129..255  后面 1 个像素，重复 257-c 次
+//   c = 128       空操作
+// 重复的像素转一次色，按 32 位一次写两个；原样的像素走和不压缩时一样的查表/翻转
+bool packbits_decode(const uint8_t* in, uint32_t len, int base, int n, uint16_t* out);
+
+// ---------------- BAND_CODEC_QOI ----------------
+// 仿 QOI，按 RGB565 的 5/6/5 分量改过，只支持 565 的 base。每个 band 从 prev=0、索引表清零开始：
+//   00iiiiii            索引表第 i 项
+//   01rrggbb            和上一个像素差 -2..1（每个分量加 2 存）
+//   10gggggg rrrrbbbb   dg -32..31（加 32），dr-dg/2、db-dg/2 -8..7（加 8）
+//   11xxxxxx            上一个像素重复 x+1 次，x 最大 61
+//   0xFE hi lo          原样的像素，大端
+// 除了索引和重复，解出来的像素都放进索引表，位置是 (r*3+g*5+b*7)&63。差值都按分量位宽回绕
+#define QOI565_OP_INDEX 0x00
+#define QOI565_OP_DIFF 0x40
+#define QOI565_OP_LUMA 0x80
+#define QOI565_OP_RUN 0xC0
+#define QOI565_OP_RGB 0xFE
+#define QOI565_RUN_MAX 62
+
+static inline int qoi565_hash(uint16_t v) {
+    return ((v >> 11) * 3 + ((v >> 5) & 63) * 5 + (v & 31) * 7) & 63;
+}
+
+bool qoi565_decode(const uint8_t* in, uint32_t len, int n, uint16_t* out);
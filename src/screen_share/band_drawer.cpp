@@ -0,0 +1,330 @@
+#include "band_drawer.h"
+#include <string.h>
+
+// 完成回调只带一个 user 指针，所以这里记住唯一的 drawer。
+// user 小于 SLOT_TOTAL 是槽位下标，PRESENT_TAG 开头的是后台缓冲的分块
+#define PRESENT_TAG 0x100
+static BandDrawer* activeDrawer = nullptr;
+
+BandDrawer::BandDrawer(FramePool& pool, BandPanel& panel)
+    : bands(0), mergedBands(0), evicted(0), frames(0), completeFrames(0), rowsSum(0), lateBands(0), staleStripes(0), rejected(0),
+      pool_(pool), panel_(panel), writing_(false), lastDrawUs_(0),
+      presentMode_(false), presentRows_(IMG_H), deadlineUs_(0),
+      dirtyMin_(IMG_H), dirtyMax_(0), hasPresented_(false), presentedId_(0),
+      sampleHook_(nullptr), sampleUser_(nullptr) {
+    for (int i = 0; i < PRESENT_CHUNKS; i++) {
+        back_[i] = nullptr;
+        chunkBusy_[i] = false;
+    }
+}
+
+void BandDrawer::begin() {
+    activeDrawer = this;
+    panel_.setDoneCallback(onBlockSent);
+}
+
+bool BandDrawer::setPresentMode(float fraction, uint32_t deadline_us) {
+    if (fraction <= 0) {
+        presentMode_ = false;
+        return true;
+    }
+    for (int i = 0; i < PRESENT_CHUNKS; i++) {
+        if (back_[i]) continue;
+        back_[i] = (uint16_t*)dma_alloc(IMG_W * PRESENT_CHUNK_LINES * 2);
+        if (!back_[i]) return false;
+        memset(back_[i], 0, IMG_W * PRESENT_CHUNK_LINES * 2);
+    }
+    if (fraction > 1) fraction = 1;
+    presentRows_ = (uint16_t)(fraction * IMG_H + 0.5f);
+    if (presentRows_ == 0) presentRows_ = 1;
+    deadlineUs_ = deadline_us;
+    presentMode_ = true;
+    return true;
+}
+
+// DMA 发送完一块的回调，在绘制线程里调用（startWindow/busy/endWrite 内部），
+// 所以 freeRing 的生产者仍然只有绘制线程
+void BandDrawer::onBlockSent(void* user) {
+    uintptr_t tag = (uintptr_t)user;
+    if (tag >= PRESENT_TAG) {
+        activeDrawer->chunkBusy_[tag - PRESENT_TAG] = false;
+    } else {
+        activeDrawer->pool_.release((uint8_t)tag);
+    }
+}
+
+bool BandDrawer::idle() {
+    bool busy = panel_.busy();
+    if (presentMode_ && track_.active && deadlineUs_ &&
+        micros() - track_.first_us >= deadlineUs_) {
+        present();
+    }
+    return busy || (presentMode_ && track_.active);
+}
+
+void BandDrawer::blank() {
+    if (writing_) {
+        panel_.endWrite(); // 等 DMA 发完，队列里的槽位全部还回去
+        writing_ = false;
+    }
+    panel_.fillScreen(0);
+    if (presentMode_) {
+        for (int i = 0; i < PRESENT_CHUNKS; i++) {
+            memset(back_[i], 0, IMG_W * PRESENT_CHUNK_LINES * 2);
+        }
+        dirtyMin_ = IMG_H;
+        dirtyMax_ = 0;
+    }
+    track_.active = false;
+}
+
+void BandDrawer::flush() {
+    if (presentMode_) {
+        if (track_.active) present();
+    } else {
+        finishFrame(lastDrawUs_);
+    }
+}
+
+void BandDrawer::ensureWriting() {
+    if (!writing_) {
+        panel_.startWrite();
+        writing_ = true;
+    }
+}
+
+void BandDrawer::snapshot(DrawStats& s) const {
+    s.bands = bands;
+    s.mergedBands = mergedBands;
+    s.evicted = evicted;
+    s.frames = frames;
+    s.completeFrames = completeFrames;
+    s.rowsSum = rowsSum;
+    s.lateBands = lateBands;
+    s.staleStripes = staleStripes;
+    s.rejected = rejected;
+    s.latency.copy(latency);
+    s.presentLatency.copy(presentLatency);
+}
+
+// ================= 每帧统计 =================
+void BandDrawer::finishFrame(uint32_t now_us) {
+    if (!track_.active) return;
+    frames++;
+    rowsSum += track_.rowCount;
+    if (track_.complete()) completeFrames++;
+    else staleStripes += track_.gaps();
+    presentLatency.add(now_us - track_.first_us);
+    sample(DRAW_SAMPLE_PRESENT, now_us - track_.first_us);
+    track_.active = false;
+}
+
+// 流式模式下记录 band 属于哪一帧，帧号变了就结算上一帧。行要等屏幕接受了窗口再记（见 markDrawn）
+void BandDrawer::trackBand(const FrameData* f, uint32_t now_us) {
+    if (!track_.active || track_.frame_id != f->frame_id) {
+        finishFrame(lastDrawUs_);
+        track_.start(f->frame_id, f->commit_us);
+    }
+    lastDrawUs_ = now_us;
+}
+
+void BandDrawer::markDrawn(const FrameData* f) {
+    if (f->width == IMG_W) { // 瓦片只更新一部分，不算行收齐
+        track_.mark(f->y_start, f->line_count);
+    }
+}
+
+// 就绪队列里 f 后面排着的、更新的帧的整行 band 已经把 f 的行全部盖住了
+bool BandDrawer::supersededInQueue(const FrameData* f) const {
+    uint32_t want = f->line_count >= 32 ? 0xFFFFFFFFu : (1u << f->line_count) - 1;
+    uint32_t got = 0;
+    uint8_t idx;
+    for (size_t i = 1; got != want && pool_.peekReady(i, idx); i++) {
+        const FrameData* g = &pool_.slots[idx];
+        if (g->width != IMG_W || !frame_newer(g->frame_id, f->frame_id)) continue;
+        int from = g->y_start > f->y_start ? g->y_start - f->y_start : 0;
+        int to = g->y_start + g->line_count - f->y_start;
+        if (to > f->line_count) to = f->line_count;
+        for (int y = from; y < to; y++) got |= 1u << y;
+    }
+    return got == want;
+}
+
+// 队头的 band 属于已经被取代的帧，并且收包线程拿不到空槽位、或者后面已经有更新的帧盖住了这几行：不画，槽位直接还回去。
+// 只是帧号旧、新帧还没到这几行时照样画，新帧还有空洞时不把旧帧最后几条也扔掉。
+// 瓦片是增量更新，之后不一定会再发，不回收
+bool BandDrawer::evictStale() {
+    uint8_t idx;
+    if (!pool_.peekReady(0, idx)) {
+        return false;
+    }
+    const FrameData* f = &pool_.slots[idx];
+    if (f->width != IMG_W || !pool_.isStale(f->frame_id)) {
+        return false;
+    }
+    if (!pool_.starved() && !supersededInQueue(f)) {
+        return false;
+    }
+    pool_.popReady(idx);
+    pool_.release(idx);
+    evicted++;
+    return true;
+}
+
+IRAM_ATTR bool BandDrawer::drawOnce() {
+    if (evictStale()) return true;
+    if (presentMode_) return presentOnce();
+
+    // 按到达顺序取 READY 的缓冲区
+    uint8_t idx;
+    if (!pool_.popReady(idx)) {
+        return false;
+    }
+    uint32_t now = micros();
+    FrameData* f = &pool_.slots[idx];
+    f->state = BUF_DISPLAYING;
+    latency.add(now - f->commit_us);
+    sample(DRAW_SAMPLE_LATENCY, now - f->commit_us);
+    trackBand(f, now);
+
+    // 就绪队列里紧跟着的、同一帧且上下相接的整行 band 合并成一个窗口
+    uint8_t group[SLOT_TOTAL];
+    int group_n = 0;
+    group[group_n++] = idx;
+    uint32_t group_bytes = f->width * f->line_count * 2;
+    int end_y = f->y_start + f->line_count;
+    uint8_t next;
+    while (f->width == IMG_W && pool_.peekReady(0, next)) {
+        FrameData* nf = &pool_.slots[next];
+        uint32_t nbytes = IMG_W * nf->line_count * 2;
+        if (nf->frame_id != f->frame_id || nf->y_start != end_y || nf->width != IMG_W ||
+            group_bytes + nbytes > DRAW_MERGE_MAX_BYTES) {
+            break;
+        }
+        pool_.popReady(next);
+        nf->state = BUF_DISPLAYING;
+        group[group_n++] = next;
+        group_bytes += nbytes;
+        end_y += nf->line_count;
+    }
+
+    ensureWriting();
+    // 槽位本身就在 DMA 内存里，直接排队发送；队列满时这里会等最老的 band 发完，
+    // 发完的槽位由 onBlockSent 还回 freeRing。
+    // 合并的 band 只发一次窗口命令，后面的槽位接着往同一个 RAMWR 里送
+    if (!panel_.startWindow(
+            f->x_start,
+            f->y_start,
+            f->width,
+            end_y - f->y_start,
+            f->lines,
+            f->width * f->line_count,
+            (void*)(uintptr_t)idx)) {
+        for (int i = 0; i < group_n; i++) {
+            pool_.release(group[i]); // 越界的 band 直接丢弃，这些行没画，不算收到
+        }
+        rejected += group_n;
+        return true;
+    }
+    for (int i = 0; i < group_n; i++) {
+        markDrawn(&pool_.slots[group[i]]);
+    }
+    for (int i = 1; i < group_n; i++) {
+        FrameData* g = &pool_.slots[group[i]];
+        panel_.pushPixels(g->lines, IMG_W * g->line_count, (void*)(uintptr_t)group[i]);
+    }
+    mergedBands += group_n - 1;
+    bands += group_n;
+    return true;
+}
+
+// ================= 整帧模式 =================
+// 把攒着的帧改过的行（按分块对齐）排进 DMA 队列，一个窗口发完
+void BandDrawer::present() {
+    uint32_t now = micros();
+    if (track_.active) {
+        hasPresented_ = true;
+        presentedId_ = track_.frame_id;
+        finishFrame(now);
+    }
+    if (dirtyMin_ >= dirtyMax_) return;
+
+    int c0 = dirtyMin_ / PRESENT_CHUNK_LINES;
+    int c1 = (dirtyMax_ - 1) / PRESENT_CHUNK_LINES;
+    int y0 = c0 * PRESENT_CHUNK_LINES;
+    int y1 = (c1 + 1) * PRESENT_CHUNK_LINES;
+    if (y1 > IMG_H) y1 = IMG_H;
+
+    ensureWriting();
+    for (int c = c0; c <= c1; c++) {
+        int lines = c == c1 ? y1 - c * PRESENT_CHUNK_LINES : PRESENT_CHUNK_LINES;
+        chunkBusy_[c] = true;
+        void* user = (void*)(uintptr_t)(PRESENT_TAG + c);
+        if (c == c0) {
+            panel_.startWindow(0, y0, IMG_W, y1 - y0, back_[c], IMG_W * lines, user);
+        } else {
+            panel_.pushPixels(back_[c], IMG_W * lines, user);
+        }
+    }
+    dirtyMin_ = IMG_H;
+    dirtyMax_ = 0;
+}
+
+IRAM_ATTR bool BandDrawer::presentOnce() {
+    uint8_t idx;
+    if (!pool_.peekReady(0, idx)) {
+        return false;
+    }
+    FrameData* f = &pool_.slots[idx];
+    int y0 = f->y_start;
+    int y1 = y0 + f->line_count;
+    if (y1 > IMG_H) y1 = IMG_H;
+
+    // 已经显示过的帧又来了 band，来晚了
+    if (f->width == IMG_W && hasPresented_ && (uint16_t)(presentedId_ - f->frame_id) <= FRAME_STALE_WINDOW &&
+        !(track_.active && track_.frame_id == f->frame_id)) {
+        pool_.popReady(idx);
+        pool_.release(idx);
+        lateBands++;
+        return true;
+    }
+    // 下一帧开始了，上一帧收到多少显示多少
+    if (track_.active && track_.frame_id != f->frame_id) {
+        present();
+    }
+    // 这条 band 要写的分块还在发送，先留在就绪队列里
+    for (int c = y0 / PRESENT_CHUNK_LINES; c <= (y1 - 1) / PRESENT_CHUNK_LINES && y0 < y1; c++) {
+        if (chunkBusy_[c]) return false;
+    }
+
+    pool_.popReady(idx);
+    uint32_t now = micros();
+    latency.add(now - f->commit_us);
+    sample(DRAW_SAMPLE_LATENCY, now - f->commit_us);
+    if (!track_.active) {
+        track_.start(f->frame_id, f->commit_us);
+    }
+    // 拷进后台缓冲，槽位马上还回去
+    int x0 = f->x_start;
+    int w = f->width;
+    if (x0 + w > IMG_W) w = x0 < IMG_W ? IMG_W - x0 : 0;
+    for (int y = y0; y < y1 && w > 0; y++) {
+        memcpy(back_[y / PRESENT_CHUNK_LINES] + (y % PRESENT_CHUNK_LINES) * IMG_W + x0,
+               f->lines + (y - y0) * f->width, w * 2);
+    }
+    pool_.release(idx);
+    if (y0 >= y1 || w <= 0) rejected++; // 整条都在屏幕外，什么也没画
+    if (y0 < y1 && w > 0) {
+        if (f->width == IMG_W) { // 瓦片只更新一部分，不算行收齐
+            track_.mark(y0, y1 - y0);
+        }
+        if (y0 < dirtyMin_) dirtyMin_ = y0;
+        if (y1 > dirtyMax_) dirtyMax_ = y1;
+    }
+    bands++;
+
+    if (track_.rowCount >= presentRows_) {
+        present();
+    }
+    return true;
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include "frame_pool.h"
+#include "frame_tracker.h"
+#include "band_panel.h"
+
+#define DRAW_MERGE_MAX_BYTES (SLOT_BYTES * 4) // 同一帧相邻 band 合并成一个窗口的字节上限
+
+// 整帧显示模式的后台缓冲按这么多行分块申请和发送，ESP32 上大块 DMA 内存不好找
+#define PRESENT_CHUNK_LINES 40
+#define PRESENT_CHUNKS ((IMG_H + PRESENT_CHUNK_LINES - 1) / PRESENT_CHUNK_LINES)
+
+// 延迟直方图，桶 i 的上限是 64us << i，最后一桶是更长的
+#define LATENCY_BUCKETS 12
+
+struct LatencyHist {
+    volatile uint32_t b[LATENCY_BUCKETS];
+
+    LatencyHist() { clear(); }
+    void add(uint32_t us) {
+        int i = 0;
+        uint32_t limit = 64;
+        while (i < LATENCY_BUCKETS - 1 && us >= limit) {
+            limit <<= 1;
+            i++;
+        }
+        b[i]++;
+    }
+    void clear() {
+        for (int i = 0; i < LATENCY_BUCKETS; i++) b[i] = 0;
+    }
+    void merge(const LatencyHist& o) {
+        for (int i = 0; i < LATENCY_BUCKETS; i++) b[i] += o.b[i];
+    }
+    void copy(const LatencyHist& o) {
+        for (int i = 0; i < LATENCY_BUCKETS; i++) b[i] = o.b[i];
+    }
+    void subtract(const LatencyHist& o) {
+        for (int i = 0; i < LATENCY_BUCKETS; i++) b[i] -= o.b[i];
+    }
+};
+
+// setSampleHook 回调的样本种类
+#define DRAW_SAMPLE_LATENCY 0 // 同 BandDrawer::latency
+#define DRAW_SAMPLE_PRESENT 1 // 同 BandDrawer::presentLatency
+
+// 绘制线程统计的一份快照。绘制线程的计数器只增不减，别的线程清零会和绘制线程的 ++ 抢着写、丢计数，
+// 所以打印的线程自己留着上一份快照，相减得到这段时间的数（32 位回绕后相减也对）
+struct DrawStats {
+    uint32_t bands;
+    uint32_t mergedBands;
+    uint32_t evicted;
+    uint32_t frames;
+    uint32_t completeFrames;
+    uint32_t rowsSum;
+    uint32_t lateBands;
+    uint32_t staleStripes;
+    uint32_t rejected;
+    LatencyHist latency;
+    LatencyHist presentLatency;
+
+    DrawStats()
+        : bands(0), mergedBands(0), evicted(0), frames(0), completeFrames(0), rowsSum(0),
+          lateBands(0), staleStripes(0), rejected(0) {}
+
+    // 变成 this - prev
+    void subtract(const DrawStats& prev) {
+        bands -= prev.bands;
+        mergedBands -= prev.mergedBands;
+        evicted -= prev.evicted;
+        frames -= prev.frames;
+        completeFrames -= prev.completeFrames;
+        rowsSum -= prev.rowsSum;
+        lateBands -= prev.lateBands;
+        staleStripes -= prev.staleStripes;
+        rejected -= prev.rejected;
+        latency.subtract(prev.latency);
+        presentLatency.subtract(prev.presentLatency);
+    }
+};
+
+// ================= 绘制调度 =================
+// 默认是流式：按到达顺序从就绪队列取 band，同一帧上下相接的合并成一个窗口排进屏幕的 DMA 队列，
+// 延迟最低，但相邻两帧的 band 会在屏幕上交错（撕裂）。
+// 整帧模式：band 先拷进后台缓冲、槽位马上还回去，一帧收齐（或收到一定比例、或超时、或下一帧开始）
+// 之后再把改过的行一次发出去。
+// 只在绘制线程里调用
+class BandDrawer {
+public:
+    BandDrawer(FramePool& pool, BandPanel& panel);
+
+    // 把 panel 的完成回调接到这个 drawer 上，一个程序里只有一个 drawer
+    void begin();
+
+    // 打开整帧模式：收到 fraction(0~1] 的行或者第一条 band 之后过了 deadline_us 就显示。
+    // fraction = 0 回到流式。后台缓冲申请失败返回 false
+    bool setPresentMode(float fraction, uint32_t deadline_us);
+
+    // 处理一条或一组就绪 band，没有能处理的返回 false
+    bool drawOnce();
+
+    // 没活干时调用，回收发完的块、检查超时。还有块在发或者有攒着没显示的帧时返回 true，
+    // 调用方应该很快再来
+    bool idle();
+
+    // 等队列发完、黑屏
+    void blank();
+
+    // 停下来之前调用：整帧模式把攒着的帧显示出去，流式模式结算最后一帧
+    void flush();
+
+    // 每个延迟样本原样交给 fn(user, DRAW_SAMPLE_*, us)，直方图之外要精确分位数时用。在绘制线程里调用
+    void setSampleHook(void (*fn)(void*, int, uint32_t), void* user) {
+        sampleHook_ = fn;
+        sampleUser_ = user;
+    }
+
+    // 任何线程都可以调用，取一份统计的快照
+    void snapshot(DrawStats& s) const;
+
+    // 下面的统计只由绘制线程写，都是累计值、不清零，别的线程只读（见 DrawStats）
+    volatile uint32_t bands;        // 发出去的 band 数
+    volatile uint32_t mergedBands;  // 并入前一个窗口、省掉 CASET/RASET/RAMWR 的 band 数
+    LatencyHist latency;            // band 提交 → 开始 DMA
+    volatile uint32_t evicted;      // 被更新的帧取代，收包拿不到槽位或者新帧已经盖住这几行时没画就回收的 band
+
+    // 每帧的统计，帧号变了（或整帧模式下显示了）才结算
+    volatile uint32_t frames;
+    volatile uint32_t completeFrames; // 240 行全部收到
+    volatile uint32_t rowsSum;        // 各帧收到的行数之和，除以 frames*240 是平均完整度
+    volatile uint32_t lateBands;      // 整帧模式下，帧已经显示了才到的 band，丢掉
+    volatile uint32_t staleStripes;   // 结算时没收到的连续行段数，这些条带上还是旧帧
+    volatile uint32_t rejected;       // 屏幕不接受的 band（窗口越界），没画，行不算收到
+    LatencyHist presentLatency;       // 第一条 band 提交 → 整帧开始发送（流式: 最后一条 band 开始发送）
+
+private:
+    static void onBlockSent(void* user);
+    void trackBand(const FrameData* f, uint32_t now_us);
+    void markDrawn(const FrameData* f);
+    void finishFrame(uint32_t now_us);
+    void sample(int kind, uint32_t us) {
+        if (sampleHook_) sampleHook_(sampleUser_, kind, us);
+    }
+    bool evictStale();
+    bool supersededInQueue(const FrameData* f) const;
+    bool presentOnce();
+    void present();
+    void ensureWriting();
+
+    FramePool& pool_;
+    BandPanel& panel_;
+    bool writing_; // 队列 DMA 期间保持 startWrite，不能每个 band 都 endWrite（endWrite 会等 DMA）
+    FrameTracker track_;
+    uint32_t lastDrawUs_; // 流式模式下当前帧最后一条 band 开始发送的时间
+
+    // 整帧模式
+    bool presentMode_;
+    uint16_t presentRows_;    // 收到这么多行就显示
+    uint32_t deadlineUs_;
+    uint16_t* back_[PRESENT_CHUNKS];
+    volatile bool chunkBusy_[PRESENT_CHUNKS]; // 这一块还在 DMA 队列里，不能往里写
+    int dirtyMin_, dirtyMax_;                 // 上次显示之后改过的行
+    bool hasPresented_;
+    uint16_t presentedId_;
+
+    void (*sampleHook_)(void*, int, uint32_t);
+    void* sampleUser_;
+};
@@ -0,0 +1,166 @@
+#include "band_fec.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int popcount16(uint16_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+BandFec::BandFec()
+    : parities(0), recovered(0), unrecoverable(0), k_(0), lines_(0), ready_(-1) {
+    memset(groups_, 0, sizeof(groups_));
+}
+
+// 找 (frame_id, first) 这一组，没有就顶掉更旧的一组
+BandFec::Group* BandFec::group(uint16_t frame_id, uint8_t first) {
+    for (int i = 0; i < 2; i++) {
+        Group& g = groups_[i];
+        if (g.used && g.frame_id == frame_id && g.first == first) return &g;
+    }
+    Group* victim = &groups_[0];
+    for (int i = 0; i < 2; i++) {
+        Group& g = groups_[i];
+        if (!g.used) {
+            victim = &g;
+            break;
+        }
+        if (frame_newer(victim->frame_id, g.frame_id) ||
+            (victim->frame_id == g.frame_id && g.first < victim->first)) {
+            victim = &g;
+        }
+    }
+    // 同一帧里更早的组已经被顶掉了，迟到的包就不要了
+    if (victim->used && victim->frame_id == frame_id && first < victim->first) return nullptr;
+    if (victim->used && frame_newer(victim->frame_id, frame_id)) return nullptr;
+    retire(*victim);
+    uint8_t* acc = victim->acc;
+    memset(victim, 0, sizeof(Group));
+    victim->acc = acc;
+    victim->used = true;
+    victim->frame_id = frame_id;
+    victim->first = first;
+    return victim;
+}
+
+void BandFec::retire(Group& g) {
+    if (!g.used || g.done) return;
+    int missing = g.count - popcount16(g.received);
+    if (missing > 0) unrecoverable += missing;
+}
+
+void BandFec::accumulate(Group& g, const uint8_t* data, uint32_t len) {
+    if (len > g.accLen) {
+        memset(g.acc + g.accLen, 0, len - g.accLen);
+        g.accLen = len;
+    }
+    uint8_t* a = g.acc;
+    uint32_t i = 0;
+    if ((((uintptr_t)a | (uintptr_t)data) & 3) == 0) {
+        for (; i + 4 <= len; i += 4) {
+            *(uint32_t*)(a + i) ^= *(const uint32_t*)(data + i);
+        }
+    }
+    for (; i < len; i++) a[i] ^= data[i];
+}
+
+void BandFec::check(int i) {
+    Group& g = groups_[i];
+    if (g.done || g.count == 0) return;
+    int got = popcount16(g.received);
+    if (got == g.count) {
+        g.done = true; // 全到了，用不上校验包
+    } else if (g.parity && got == g.count - 1) {
+        ready_ = i;
+    }
+}
+
+void BandFec::addBand(const uint8_t* header, const uint8_t* payload, uint32_t len) {
+    if (k_ == 0 || len > SLOT_BYTES) return;
+    BandHeader h;
+    band_parse_header(header, h);
+    int size = band_src_size(h.res);
+    if (h.lines == 0 || size == 0 || h.y0 % lines_ != 0) return;
+    int idx = h.y0 / lines_;
+    Group* g = group(h.frame_id, idx - idx % k_);
+    if (!g || g->done) return;
+    uint16_t bit = 1u << (idx - g->first);
+    if (g->received & bit) return; // 重复的包
+    g->received |= bit;
+    if (!g->parity) {
+        // 校验包还没到，先按分辨率算出这一组有几个 band
+        int total = (size + lines_ - 1) / lines_ - g->first;
+        g->count = total < k_ ? total : k_;
+    }
+    g->lenXor ^= (uint16_t)len;
+    g->flagsXor ^= header[4];
+    accumulate(*g, payload, len);
+    check(g - groups_);
+}
+
+bool BandFec::addParity(const uint8_t* header, const uint8_t* rest, uint32_t len) {
+    const uint32_t extra = PARITY_HEADER_BYTES - BAND_HEADER_BYTES;
+    if (len < extra || len - extra > SLOT_BYTES) return false;
+    uint8_t ph[PARITY_HEADER_BYTES];
+    memcpy(ph, header, BAND_HEADER_BYTES);
+    memcpy(ph + BAND_HEADER_BYTES, rest, extra);
+    ParityHeader p;
+    band_parse_parity_header(ph, p);
+    if (p.lines == 0 || p.count == 0 || p.count > p.k || p.first % p.k != 0) return false;
+
+    if (!groups_[0].acc) {
+        // 第一次收到校验包时才申请累加器
+        for (int i = 0; i < 2; i++) {
+            groups_[i].acc = (uint8_t*)malloc(SLOT_BYTES);
+            if (!groups_[i].acc) return false;
+        }
+    }
+    if (p.k != k_ || p.lines != lines_) {
+        // 发送端换了分组方式，之前累加的都作废
+        for (int i = 0; i < 2; i++) groups_[i].used = false;
+        ready_ = -1;
+        k_ = p.k;
+        lines_ = p.lines;
+    }
+    parities++;
+
+    Group* g = group(p.frame_id, p.first);
+    if (!g || g->done || g->parity) return true;
+    g->parity = true;
+    g->count = p.count;
+    g->lenXor ^= p.lenXor;
+    g->flagsXor ^= p.flagsXor;
+    accumulate(*g, rest + extra, len - extra);
+    check(g - groups_);
+    return true;
+}
+
+int BandFec::takeRecovered(uint8_t* header, uint8_t* payload, uint32_t cap) {
+    if (ready_ < 0) return -1;
+    Group& g = groups_[ready_];
+    ready_ = -1;
+    g.done = true;
+    int missing = 0;
+    while (g.received & (1u << missing)) missing++;
+    // 补出来的负载不会比校验包长
+    if (g.lenXor > g.accLen || g.lenXor > cap) {
+        unrecoverable++;
+        return -1;
+    }
+    uint16_t y0 = (g.first + missing) * lines_;
+    header[0] = g.frame_id >> 8;
+    header[1] = g.frame_id & 0xFF;
+    header[2] = y0 >> 8;
+    header[3] = y0 & 0xFF;
+    header[4] = g.flagsXor;
+    memcpy(payload, g.acc, g.lenXor);
+    recovered++;
+    return g.lenXor;
+}
+
+void BandFec::discardRecovered() {
+    if (ready_ < 0) return;
+    groups_[ready_].done = true;
+    ready_ = -1;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include "band_protocol.h"
+#include "frame_pool.h"
+
+// ================= XOR 校验恢复（FEC） =================
+// 发送端每 K 个连续的 band 后面发一个校验包（BAND_PKT_PARITY），负载是这 K 个 band 负载的异或，
+// 长度和 flags 字节的异或在校验包头里，y0 由 band 的序号算出来。
+// 接收端不把 K 个负载都存下来：每组只留一个累加器，收到的 band 和校验包都异或进去，
+// 组里只差一个 band 时累加器就是丢掉的那个负载，不用等重传。
+// 组按帧号和序号（y0 / 每个 band 的行数）划分，K 和行数从校验包里学，收到第一个校验包之后才开始累加。
+// 只在收包线程里调用
+class BandFec {
+public:
+    BandFec();
+
+    // 收到 band 时调用，要在处理之前（负载还是线上的样子）
+    void addBand(const uint8_t* header, const uint8_t* payload, uint32_t len);
+    // 收到校验包时调用，rest 是 band 头之后的部分（校验包头剩下的 4 字节 + 负载）。格式不对返回 false
+    bool addParity(const uint8_t* header, const uint8_t* rest, uint32_t len);
+
+    // 有 band 能补回来
+    bool ready() const { return ready_ >= 0; }
+    // 把补回来的 band 头和负载写出来，返回负载长度；负载放不进 cap 或者长度对不上返回 -1
+    int takeRecovered(uint8_t* header, uint8_t* payload, uint32_t cap);
+    // 没有槽位放补回来的 band，只能不要了
+    void discardRecovered();
+
+    // 统计
+    volatile uint32_t parities;      // 收到的校验包
+    volatile uint32_t recovered;     // 补回来的 band
+    volatile uint32_t unrecoverable; // 一组丢了两个以上，或者丢了 band 又丢了校验包
+
+private:
+    struct Group {
+        bool used;
+        bool parity;       // 校验包已经到了
+        bool done;         // 已经补过或者全到了
+        uint16_t frame_id;
+        uint8_t first;
+        uint8_t count;     // 组里的 band 数
+        uint16_t received; // 收到的 band，第 i 位是组里第 i 个
+        uint16_t lenXor;
+        uint8_t flagsXor;
+        uint32_t accLen;   // acc 里有效的长度，后面的当 0
+        uint8_t* acc;
+    };
+
+    Group* group(uint16_t frame_id, uint8_t first);
+    void retire(Group& g);
+    void accumulate(Group& g, const uint8_t* data, uint32_t len);
+    void check(int i);
+
+    Group groups_[2]; // 当前组和上一组，乱序时上一组的包还能到
+    uint8_t k_;
+    uint8_t lines_;
+    int ready_;
+};
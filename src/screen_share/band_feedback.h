@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include "band_protocol.h"
+#include "band_transport.h"
+#include "frame_pool.h"
+
+// ================= 反馈包 =================
+// 接收端定期把收包数、丢包数、空闲槽位和绘制速度发回发送端（格式见 band_protocol.h），
+// 发送端据此把速率压在接收端刚好吃得下的位置，不用再手调包间隔。
+// 计数器用的是不清零的累计值，调试输出清零统计不影响这里。只在收包线程里调用
+class BandFeedback {
+public:
+    BandFeedback(BandTransport& transport, FramePool& pool)
+        : sent(0), transport_(transport), pool_(pool), interval_ms_(0), last_ms_(0),
+          seq_(0), packets_(0), drops_(0), draws_(0) {}
+
+    // 多久发一次，0 表示不发
+    void setInterval(uint32_t ms) { interval_ms_ = ms; }
+
+    // 收包循环里调用，到时间了就发一个统计反馈包。packets/drops/draws 是累计值。
+    // 这段时间一个包都没收到就不发，发送端多半已经停了
+    void tick(uint32_t now_ms, uint32_t packets, uint32_t drops, uint32_t draws) {
+        if (interval_ms_ == 0 || now_ms - last_ms_ < interval_ms_) return;
+        FeedbackStats s;
+        s.interval_ms = clamp16(now_ms - last_ms_);
+        s.packets = clamp16(packets - packets_);
+        s.drops = clamp16(drops - drops_);
+        s.draws = clamp16(draws - draws_);
+        last_ms_ = now_ms;
+        packets_ = packets;
+        drops_ = drops;
+        draws_ = draws;
+        if (s.packets == 0) return;
+        s.seq = seq_++;
+        s.freeSlots = (uint8_t)pool_.freeCount();
+        s.slots = FRAME_BUF_COUNT;
+        uint8_t buf[FEEDBACK_STATS_BYTES];
+        band_write_feedback_stats(buf, s);
+        if (transport_.reply(buf, sizeof(buf))) sent++;
+    }
+
+    volatile uint32_t sent; // 发出去的反馈包
+
+private:
+    static uint16_t clamp16(uint32_t v) { return v > 0xFFFF ? 0xFFFF : (uint16_t)v; }
+
+    BandTransport& transport_;
+    FramePool& pool_;
+    uint32_t interval_ms_;
+    uint32_t last_ms_;
+    uint16_t seq_;
+    uint32_t packets_;
+    uint32_t drops_;
+    uint32_t draws_;
+};
@@ -0,0 +1,99 @@
+#include "band_nack.h"
+#include <string.h>
+
+BandNack::BandNack(BandTransport& transport)
+    : nacks(0), nackRows(0), transport_(transport), delay_ms_(0),
+      active_(false), frame_id_(0), size_(0), high_(0), checked_(0), nackedTo_(0),
+      idleRounds_(0), lastBand_ms_(0), lastTick_ms_(0), rowSize_(0) {
+    memset(rows_, 0, sizeof(rows_));
+    memset(rowFrame_, 0, sizeof(rowFrame_));
+}
+
+void BandNack::onBand(uint16_t frame_id, int src_size, int y0, int lines, uint32_t now_ms) {
+    if (y0 + lines > src_size) lines = src_size - y0;
+    if (lines <= 0) return;
+
+    bool restart = active_ && frame_restarted(frame_id, frame_id_);
+    if (src_size != rowSize_ || restart) {
+        // 分辨率变了，行号对不上；或者发送端重启，帧号从头开始。之前的记录都不算
+        rowSize_ = src_size;
+        for (int y = 0; y < IMG_H; y++) rowFrame_[y] = frame_id - 1;
+    }
+    for (int y = y0; y < y0 + lines; y++) {
+        if (!frame_newer(rowFrame_[y], frame_id)) rowFrame_[y] = frame_id;
+    }
+
+    if (!active_ || restart || size_ != src_size || frame_newer(frame_id, frame_id_)) {
+        active_ = true;
+        frame_id_ = frame_id;
+        size_ = src_size;
+        memset(rows_, 0, sizeof(rows_));
+        high_ = 0;
+        checked_ = 0;
+        nackedTo_ = 0;
+        idleRounds_ = 0;
+    } else if (frame_id != frame_id_) {
+        return; // 更旧的帧，已经不要了
+    }
+    for (int y = y0; y < y0 + lines; y++) rows_[y >> 5] |= 1u << (y & 31);
+    if (y0 + lines > high_) high_ = y0 + lines;
+    lastBand_ms_ = now_ms;
+}
+
+bool BandNack::covered(uint16_t frame_id, int src_size, int y0, int lines) const {
+    if (src_size != rowSize_) return false;
+    if (y0 + lines > src_size) lines = src_size - y0;
+    for (int y = y0; y < y0 + lines; y++) {
+        if (!frame_newer(frame_id, rowFrame_[y]) && !frame_restarted(frame_id, rowFrame_[y])) return true;
+    }
+    return false;
+}
+
+bool BandNack::delivered(uint16_t frame_id, int src_size, int y0, int lines) const {
+    if (src_size != rowSize_) return false;
+    if (y0 + lines > src_size) lines = src_size - y0;
+    if (lines <= 0) return false;
+    for (int y = y0; y < y0 + lines; y++) {
+        if (rowFrame_[y] != frame_id) return false;
+    }
+    return true;
+}
+
+void BandNack::tick(uint32_t now_ms) {
+    if (delay_ms_ == 0 || !active_ || now_ms - lastTick_ms_ < delay_ms_) return;
+    lastTick_ms_ = now_ms;
+    if (now_ms - lastBand_ms_ >= 2 * delay_ms_) {
+        // 帧停下来了，缺的行整帧再要一遍
+        if (idleRounds_ >= NACK_IDLE_ROUNDS) return;
+        idleRounds_++;
+        request(0, size_);
+        nackedTo_ = size_;
+        return;
+    }
+    int to = checked_;
+    checked_ = high_;
+    if (to > nackedTo_) {
+        request(nackedTo_, to);
+        nackedTo_ = to;
+    }
+}
+
+// 把 [from, to) 里缺的行按区间发出去，区间太多就分几个包
+void BandNack::request(int from, int to) {
+    NackRange r[BAND_NACK_MAX_RANGES];
+    uint8_t buf[NACK_HEADER_BYTES + 2 * BAND_NACK_MAX_RANGES];
+    int n = 0;
+    for (int y = from; y < to; y++) {
+        if (has(y)) continue;
+        int start = y;
+        while (y < to && !has(y)) y++;
+        r[n].y0 = (uint8_t)start;
+        r[n].lines = (uint8_t)(y - start);
+        nackRows += y - start;
+        if (++n == BAND_NACK_MAX_RANGES) {
+            if (transport_.reply(buf, band_write_nack(buf, frame_id_, r, n))) nacks++;
+            n = 0;
+        }
+    }
+    if (n && transport_.reply(buf, band_write_nack(buf, frame_id_, r, n))) nacks++;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include "band_protocol.h"
+#include "band_transport.h"
+
+#define NACK_ROW_WORDS ((IMG_H + 31) / 32)
+#define NACK_IDLE_ROUNDS 2 // 一帧停下来以后最多再整帧要几次
+
+// ================= 丢失 band 的重传请求（NACK） =================
+// 按源分辨率的行记下当前帧收到了哪些行。发送端按 y0 从上往下发，
+// 所以比已经收到的最靠下的行还靠上的空洞就是丢了（或者乱序还没到）：
+// 每次 tick 只要上一次 tick 之前就已经在最高行上面的空洞，等够一个间隔再要，乱序的包不会被误要。
+// 帧停下来（静止画面、最后几个 band 丢了）超过两个间隔没有新 band，就把整帧缺的行再要一遍，最多 NACK_IDLE_ROUNDS 次。
+// 已经被更新的帧开始取代的帧不再要，要回来也是过期的。
+// 另外按行记住最后画到这一行的帧号，重发的 band 到达时这些行已经被同一帧或者更新的帧画过了就不要，
+// 不然会把新内容盖回旧的，XOR 增量还会被重复应用。帧号比记录旧了 FRAME_STALE_WINDOW 以上当成发送端重启，记录清掉重来。
+// 只在收包线程里调用
+class BandNack {
+public:
+    explicit BandNack(BandTransport& transport);
+
+    // 等多久再要，毫秒，0 表示不发 NACK
+    void setDelay(uint32_t ms) { delay_ms_ = ms; }
+
+    // band 没有过期、要处理时调用，行是源分辨率下的
+    void onBand(uint16_t frame_id, int src_size, int y0, int lines, uint32_t now_ms);
+    // 重发的 band 要画的行已经被这一帧或者更新的帧画过了
+    bool covered(uint16_t frame_id, int src_size, int y0, int lines) const;
+    // 这几行已经收过同一帧的 band 了，用来丢网络复制出来的包。只认同一个帧号，发送端重启后帧号变小的不算
+    bool delivered(uint16_t frame_id, int src_size, int y0, int lines) const;
+    // 收包循环里调用，到时间了就发 NACK
+    void tick(uint32_t now_ms);
+
+    // 统计
+    volatile uint32_t nacks;    // 发出去的 NACK 包
+    volatile uint32_t nackRows; // 要过的行数
+
+private:
+    bool has(int y) const { return (rows_[y >> 5] >> (y & 31)) & 1; }
+    void request(int from, int to);
+
+    BandTransport& transport_;
+    uint32_t delay_ms_;
+
+    // 当前帧
+    bool active_;
+    uint16_t frame_id_;
+    int size_;
+    uint32_t rows_[NACK_ROW_WORDS];
+    int high_;     // 收到的最靠下的 band 的结束行
+    int checked_;  // 上一次 tick 时的 high_，这上面的空洞已经等够了
+    int nackedTo_; // 这上面的空洞已经要过了
+    uint8_t idleRounds_;
+    uint32_t lastBand_ms_;
+    uint32_t lastTick_ms_;
+
+    // 每一行最后是哪一帧画的，rowSize_ 是这些记录的源分辨率，0 表示还没有
+    int rowSize_;
+    uint16_t rowFrame_[IMG_H];
+};
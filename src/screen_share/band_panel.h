@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+
+// ================= 屏幕接口 =================
+// 绘制调度只通过这个接口往屏幕发 band。
+// ESP32 上是 TFT_eSPI 的 DMA 队列（tft_panel.h），PC 上是内存里的虚拟屏（host/virtual_panel.h）。
+// 发完一块像素后，实现要在绘制线程里调用 setDoneCallback 设置的回调，参数是排队时给的 user
+class BandPanel {
+public:
+    virtual ~BandPanel() {}
+
+    virtual void setDoneCallback(void (*cb)(void* user)) = 0;
+
+    // 开始批量发送（片选/总线占用），endWrite 会等所有排队的块发完
+    virtual void startWrite() = 0;
+    virtual void endWrite() = 0;
+
+    // 设置窗口并排队发送第一块像素，队列满时等最老的一块发完；窗口越界返回 false
+    virtual bool startWindow(int32_t x, int32_t y, int32_t w, int32_t h,
+                             uint16_t* buf, uint32_t len, void* user) = 0;
+    // 接着上一个窗口继续排队发送像素
+    virtual bool pushPixels(uint16_t* buf, uint32_t len, void* user) = 0;
+
+    // 回收已经发完的块，还有块在发返回 true
+    virtual bool busy() = 0;
+    // 还在队列里的块数
+    virtual uint8_t queued() = 0;
+
+    virtual void fillScreen(uint16_t color) = 0;
+};
@@ -0,0 +1,400 @@
+#pragma once
+#include <stdint.h>
+
+// ================= band 数据报格式 =================
+// 每个 UDP 包是一条 band：5 字节头 + 像素
+//   [0..1] frame_id   大端
+//   [2..3] y0         源分辨率下的起始行，大端；[2] 的 bit6 (BAND_RETX_FLAG) 表示这是按 NACK 重发的 band
+//   [4]    flags      bit7-6 分辨率 0=240,1=180,2=120
+//                     bit5-4 颜色   0=RGB565小端,1=RGB332,2=RGB565大端(屏幕字节序),3=压缩
+//                     bit3-0 行数
+// 像素按行紧排，每行 src_w 个像素
+// 颜色是 3 时负载第一个字节是编码：bit7-4 编码方式(BAND_CODEC_*)，bit2 关键帧，bit1-0 解码后的像素格式(0/1/2)，
+// 后面是编码后的数据，格式见 band_codec.h
+//
+// v2 扩展包：y0 最高位置 1（band 的 y0 最大 239，不会冲突），[2] 的低 7 位是包类型
+//   BAND_PKT_TILE 矩形瓦片，8 字节头：
+//   [0..1] frame_id   [2] 0x80|BAND_PKT_TILE
+//   [3]    flags      bit7-6 分辨率、bit5-4 颜色，和 band 一样；bit3-0 保留
+//   [4] x  [5] y  [6] w  [7] h   源分辨率下的矩形
+//   像素按行紧排，每行 w 个像素
+//   BAND_PKT_PALETTE 调色板，5 字节头，和 band 头一样长：
+//   [0..1] frame_id   [2] 0x80|BAND_PKT_PALETTE
+//   [3]    项数-1     [4] 版本号，调色板内容变了才加一
+//   后面是 项数 个大端 RGB565。用调色板的 band（BAND_CODEC_PAL4/PAL8）编码字节的 bit1-0 是版本号的低 2 位，
+//   这一帧的调色板没到时，版本号一样的旧调色板也能用
+//   BAND_PKT_PARITY XOR 校验（FEC），9 字节头：
+//   [0..1] frame_id   [2] 0x80|BAND_PKT_PARITY
+//   [3]    组里第一个 band 的序号（y0 / 每个 band 的行数）
+//   [4]    bit7-4 每组 band 数 K-1，bit3-0 每个 band 的行数
+//   [5]    这一组实际的 band 数，一帧的最后一组可能不满 K 个
+//   [6..7] 组里每个 band 负载长度的异或，大端   [8] 组里每个 band flags 字节的异或
+//   后面是组里每个 band 负载（不含头部，短的补 0）的异或，丢了一个 band 时用来补回来，见 band_fec.h
+//   BAND_PKT_MULTI 同一帧的几个 band 拼成一个包，5 字节头：
+//   [0..1] frame_id   [2] 0x80|BAND_PKT_MULTI   [3] 子 band 数   [4] 保留，填 0
+//   后面是子 band，每个 4 字节头 + 负载：[0] y0  [1] flags（和 band 头的 [4] 一样）  [2..3] 负载长度，大端。
+//   子 band 的负载和单独发的 band 一样，接收端拆开后逐个当 band 处理。小 band（120/RGB332）一个包能多带几条
+//   BAND_PKT_FRAG 大 band 的一个分片，10 字节头：
+//   [0..1] frame_id   [2] 0x80|BAND_PKT_FRAG
+//   [3]    分片序号   [4] 分片数   [5..6] 这一片在 band 负载里的偏移，大端
+//   [7]    y0         [8] 行数，最多 FRAG_MAX_LINES   [9] bit7-6 分辨率、bit5-4 颜色，和 band 的 flags 一样，bit3-0 保留
+//   同一个 band 的分片靠 (frame_id, y0) 认，负载拼起来就是一个不压缩的 band，现在只支持 240 宽。见 band_reassembly.h
+//
+// 反馈包：接收端 → 发送端，发到最近一个 band 的源地址，发送端用来调节发送速率
+//   [0] BAND_FEEDBACK_MAGIC   [1] 类型 BAND_FB_*
+//   BAND_FB_STATS 统计，14 字节：
+//   [2..3]   序号，大端，每发一个加一，发送端用来发现反馈包丢了
+//   [4..5]   这段统计的时长，毫秒，大端
+//   [6..7]   这段时间收到的包数   [8..9] 丢掉的包数（没有槽位/过期帧/没画就回收）
+//   [10..11] 这段时间画出去的 band 数
+//   [12]     现在的空闲槽位数     [13] 槽位总数
+//   计数都是 16 位，超过 65535 按 65535 算
+//   BAND_FB_NACK 重传请求，5 + 2n 字节：
+//   [2..3]   frame_id，大端     [4] 区间数 n，最多 BAND_NACK_MAX_RANGES
+//   后面 n 个区间，每个 [起始行, 行数]，源分辨率下的行。发送端重发和这些行相交的 band，头部带 BAND_RETX_FLAG
+#define IMG_W 240
+#define IMG_H 240
+#define BAND_HEADER_BYTES 5
+
+#define BAND_RES_240 0
+#define BAND_RES_180 1
+#define BAND_RES_120 2
+
+#define BAND_COLOR_RGB565 0
+#define BAND_COLOR_RGB332 1
+#define BAND_COLOR_RGB565_BE 2
+#define BAND_COLOR_CODEC 3
+
+#define BAND_CODEC_XOR 1   // 和接收端保存的上一帧做异或，异或结果按 0 游程编码
+#define BAND_CODEC_RLE 2   // PackBits 游程编码，没有跨 band 的状态
+#define BAND_CODEC_QOI 3   // 仿 QOI 的 RGB565 无损压缩，没有跨 band 的状态
+#define BAND_CODEC_PAL4 4  // 4 位调色板索引，一个字节两个像素，高 4 位在前
+#define BAND_CODEC_PAL8 5  // 8 位调色板索引
+#define BAND_CODEC_YUV420 6 // Y 平面 + 半分辨率的 U、V 平面，每像素 12 位，编码字节 bit1-0 为 0
+#define BAND_CODEC_JPEG 7   // 一张完整的基线 JPEG，宽是源宽、高是 band 行数，编码字节 bit1-0 为 0，见 jpeg_slice.h
+#define BAND_CODEC_KEY 0x04
+
+// YUV 4:2:0 band 编码字节后面的长度：Y 是 w*lines，U、V 各 (w/2)*((lines+1)/2)，行数是奇数时最后一行单独一行色度
+static inline uint32_t band_yuv420_bytes(int w, int lines) {
+    return (uint32_t)w * lines + 2u * (w / 2) * ((lines + 1) / 2);
+}
+
+static inline uint8_t band_codec_byte(uint8_t codec, uint8_t base, bool key) {
+    return (uint8_t)((codec << 4) | (key ? BAND_CODEC_KEY : 0) | (base & 0x03));
+}
+
+#define BAND_EXT_FLAG 0x80
+#define BAND_PKT_TILE 1
+#define TILE_HEADER_BYTES 8
+#define BAND_PKT_PALETTE 2
+#define BAND_PKT_PARITY 3
+#define PARITY_HEADER_BYTES 9
+#define BAND_FEC_MAX_K 16
+#define BAND_PKT_MULTI 4
+#define MULTI_SUB_HEADER_BYTES 4
+#define BAND_PKT_FRAG 5
+#define FRAG_HEADER_BYTES 10
+#define FRAG_MAX_COUNT 32 // 一个 band 最多分几片，接收端用 32 位的位图记
+#define FRAG_MAX_LINES 32 // 分片 band 最多几行，接收端一个大槽位
+
+#define BAND_FEEDBACK_MAGIC 0xFB
+#define BAND_FB_STATS 1
+#define FEEDBACK_STATS_BYTES 14
+#define BAND_FB_NACK 2
+#define NACK_HEADER_BYTES 5
+#define BAND_NACK_MAX_RANGES 32
+
+#define BAND_RETX_FLAG 0x40
+
+struct BandHeader {
+    uint16_t frame_id;
+    uint16_t y0;
+    uint8_t res;
+    uint8_t color;
+    uint8_t lines;
+    bool retx; // 重发的 band，只在解析时填
+};
+
+// a 比 b 新。16 位帧号会回绕，按差值的符号比较，前提是两者相差不到 32768 帧
+static inline bool frame_newer(uint16_t a, uint16_t b) {
+    return (int16_t)(a - b) > 0;
+}
+
+// 比最新帧旧不超过这么多帧的 band 算过期；旧得更多的当成发送端重启、帧号重新开始
+#define FRAME_STALE_WINDOW 32
+
+// id 比 newest 旧了 FRAME_STALE_WINDOW 帧以上，当成发送端重启了
+static inline bool frame_restarted(uint16_t id, uint16_t newest) {
+    return (uint16_t)(newest - id) > FRAME_STALE_WINDOW && frame_newer(newest, id);
+}
+
+static inline void band_parse_header(const uint8_t* h, BandHeader& out) {
+    out.frame_id = (h[0] << 8) | h[1];
+    out.y0 = ((h[2] & 0x3F) << 8) | h[3];
+    out.retx = (h[2] & BAND_RETX_FLAG) != 0;
+    out.res = (h[4] >> 6) & 0x03;
+    out.color = (h[4] >> 4) & 0x03;
+    out.lines = h[4] & 0x0F;
+}
+
+static inline void band_write_header(uint8_t* h, const BandHeader& b) {
+    h[0] = b.frame_id >> 8;
+    h[1] = b.frame_id & 0xFF;
+    h[2] = b.y0 >> 8;
+    h[3] = b.y0 & 0xFF;
+    h[4] = ((b.res & 0x03) << 6) | ((b.color & 0x03) << 4) | (b.lines & 0x0F);
+}
+
+struct TileHeader {
+    uint16_t frame_id;
+    uint8_t res;
+    uint8_t color;
+    uint8_t x, y, w, h;
+};
+
+static inline bool band_is_ext(const uint8_t* h) { return h[2] & BAND_EXT_FLAG; }
+static inline uint8_t band_ext_type(const uint8_t* h) { return h[2] & 0x7F; }
+
+static inline void band_parse_tile_header(const uint8_t* h, TileHeader& out) {
+    out.frame_id = (h[0] << 8) | h[1];
+    out.res = (h[3] >> 6) & 0x03;
+    out.color = (h[3] >> 4) & 0x03;
+    out.x = h[4];
+    out.y = h[5];
+    out.w = h[6];
+    out.h = h[7];
+}
+
+struct PaletteHeader {
+    uint16_t frame_id;
+    uint16_t entries; // 1..256
+    uint8_t version;
+};
+
+static inline void band_parse_palette_header(const uint8_t* h, PaletteHeader& out) {
+    out.frame_id = (h[0] << 8) | h[1];
+    out.entries = h[3] + 1;
+    out.version = h[4];
+}
+
+static inline void band_write_palette_header(uint8_t* h, const PaletteHeader& p) {
+    h[0] = p.frame_id >> 8;
+    h[1] = p.frame_id & 0xFF;
+    h[2] = BAND_EXT_FLAG | BAND_PKT_PALETTE;
+    h[3] = (uint8_t)(p.entries - 1);
+    h[4] = p.version;
+}
+
+static inline void band_write_multi_header(uint8_t* h, uint16_t frame_id, uint8_t count) {
+    h[0] = frame_id >> 8;
+    h[1] = frame_id & 0xFF;
+    h[2] = BAND_EXT_FLAG | BAND_PKT_MULTI;
+    h[3] = count;
+    h[4] = 0;
+}
+
+// 子 band 头：y0、flags 和负载长度
+static inline void band_write_multi_sub(uint8_t* p, uint8_t y0, uint8_t flags, uint16_t len) {
+    p[0] = y0;
+    p[1] = flags;
+    p[2] = len >> 8;
+    p[3] = len & 0xFF;
+}
+
+struct FragHeader {
+    uint16_t frame_id;
+    uint8_t index;
+    uint8_t count;
+    uint16_t offset;
+    uint8_t y0;
+    uint8_t lines;
+    uint8_t res;
+    uint8_t color;
+};
+
+static inline void band_parse_frag_header(const uint8_t* h, FragHeader& out) {
+    out.frame_id = (h[0] << 8) | h[1];
+    out.index = h[3];
+    out.count = h[4];
+    out.offset = (h[5] << 8) | h[6];
+    out.y0 = h[7];
+    out.lines = h[8];
+    out.res = (h[9] >> 6) & 0x03;
+    out.color = (h[9] >> 4) & 0x03;
+}
+
+static inline void band_write_frag_header(uint8_t* h, const FragHeader& f) {
+    h[0] = f.frame_id >> 8;
+    h[1] = f.frame_id & 0xFF;
+    h[2] = BAND_EXT_FLAG | BAND_PKT_FRAG;
+    h[3] = f.index;
+    h[4] = f.count;
+    h[5] = f.offset >> 8;
+    h[6] = f.offset & 0xFF;
+    h[7] = f.y0;
+    h[8] = f.lines;
+    h[9] = ((f.res & 0x03) << 6) | ((f.color & 0x03) << 4);
+}
+
+struct ParityHeader {
+    uint16_t frame_id;
+    uint8_t first;    // 组里第一个 band 的序号
+    uint8_t k;        // 每组 band 数，1..BAND_FEC_MAX_K
+    uint8_t lines;    // 每个 band 的行数
+    uint8_t count;    // 这一组实际的 band 数
+    uint16_t lenXor;
+    uint8_t flagsXor;
+};
+
+static inline void band_parse_parity_header(const uint8_t* h, ParityHeader& out) {
+    out.frame_id = (h[0] << 8) | h[1];
+    out.first = h[3];
+    out.k = (h[4] >> 4) + 1;
+    out.lines = h[4] & 0x0F;
+    out.count = h[5];
+    out.lenXor = (h[6] << 8) | h[7];
+    out.flagsXor = h[8];
+}
+
+static inline void band_write_parity_header(uint8_t* h, const ParityHeader& p) {
+    h[0] = p.frame_id >> 8;
+    h[1] = p.frame_id & 0xFF;
+    h[2] = BAND_EXT_FLAG | BAND_PKT_PARITY;
+    h[3] = p.first;
+    h[4] = (uint8_t)(((p.k - 1) << 4) | (p.lines & 0x0F));
+    h[5] = p.count;
+    h[6] = p.lenXor >> 8;
+    h[7] = p.lenXor & 0xFF;
+    h[8] = p.flagsXor;
+}
+
+// 把已经写好的 band 头标成重发
+static inline void band_mark_retx(uint8_t* h) {
+    h[2] |= BAND_RETX_FLAG;
+}
+
+struct NackRange {
+    uint8_t y0;
+    uint8_t lines;
+};
+
+struct FeedbackStats {
+    uint16_t seq;
+    uint16_t interval_ms;
+    uint16_t packets;
+    uint16_t drops;
+    uint16_t draws;
+    uint8_t freeSlots;
+    uint8_t slots;
+};
+
+// 不是统计反馈包返回 false
+static inline bool band_parse_feedback_stats(const uint8_t* p, int len, FeedbackStats& out) {
+    if (len < FEEDBACK_STATS_BYTES || p[0] != BAND_FEEDBACK_MAGIC || p[1] != BAND_FB_STATS) return false;
+    out.seq = (p[2] << 8) | p[3];
+    out.interval_ms = (p[4] << 8) | p[5];
+    out.packets = (p[6] << 8) | p[7];
+    out.drops = (p[8] << 8) | p[9];
+    out.draws = (p[10] << 8) | p[11];
+    out.freeSlots = p[12];
+    out.slots = p[13];
+    return true;
+}
+
+static inline void band_write_feedback_stats(uint8_t* p, const FeedbackStats& s) {
+    p[0] = BAND_FEEDBACK_MAGIC;
+    p[1] = BAND_FB_STATS;
+    p[2] = s.seq >> 8;
+    p[3] = s.seq & 0xFF;
+    p[4] = s.interval_ms >> 8;
+    p[5] = s.interval_ms & 0xFF;
+    p[6] = s.packets >> 8;
+    p[7] = s.packets & 0xFF;
+    p[8] = s.drops >> 8;
+    p[9] = s.drops & 0xFF;
+    p[10] = s.draws >> 8;
+    p[11] = s.draws & 0xFF;
+    p[12] = s.freeSlots;
+    p[13] = s.slots;
+}
+
+// 写一个 NACK 包，返回长度。n 不能超过 BAND_NACK_MAX_RANGES
+static inline int band_write_nack(uint8_t* p, uint16_t frame_id, const NackRange* r, int n) {
+    p[0] = BAND_FEEDBACK_MAGIC;
+    p[1] = BAND_FB_NACK;
+    p[2] = frame_id >> 8;
+    p[3] = frame_id & 0xFF;
+    p[4] = (uint8_t)n;
+    for (int i = 0; i < n; i++) {
+        p[NACK_HEADER_BYTES + 2 * i] = r[i].y0;
+        p[NACK_HEADER_BYTES + 2 * i + 1] = r[i].lines;
+    }
+    return NACK_HEADER_BYTES + 2 * n;
+}
+
+// 解析 NACK 包，out 至少要有 BAND_NACK_MAX_RANGES 项。返回区间数，不是 NACK 包或者长度不对返回 -1
+static inline int band_parse_nack(const uint8_t* p, int len, uint16_t& frame_id, NackRange* out) {
+    if (len < NACK_HEADER_BYTES || p[0] != BAND_FEEDBACK_MAGIC || p[1] != BAND_FB_NACK) return -1;
+    int n = p[4];
+    if (n > BAND_NACK_MAX_RANGES || len < NACK_HEADER_BYTES + 2 * n) return -1;
+    frame_id = (p[2] << 8) | p[3];
+    for (int i = 0; i < n; i++) {
+        out[i].y0 = p[NACK_HEADER_BYTES + 2 * i];
+        out[i].lines = p[NACK_HEADER_BYTES + 2 * i + 1];
+    }
+    return n;
+}
+
+static inline void band_write_tile_header(uint8_t* h, const TileHeader& t) {
+    h[0] = t.frame_id >> 8;
+    h[1] = t.frame_id & 0xFF;
+    h[2] = BAND_EXT_FLAG | BAND_PKT_TILE;
+    h[3] = ((t.res & 0x03) << 6) | ((t.color & 0x03) << 4);
+    h[4] = t.x;
+    h[5] = t.y;
+    h[6] = t.w;
+    h[7] = t.h;
+}
+
+// 源分辨率的宽高，非法值返回 0
+static inline int band_src_size(uint8_t res) {
+    switch (res) {
+        case BAND_RES_240: return 240;
+        case BAND_RES_180: return 180;
+        case BAND_RES_120: return 120;
+        default: return 0;
+    }
+}
+
+static inline int band_bytes_per_px(uint8_t color) {
+    return color == BAND_COLOR_RGB332 ? 1 : 2;
+}
+
+// ================= 源坐标 → 屏幕坐标 =================
+// 和 band 的放大方式保持一致，瓦片和整行 band 拼在一起不会错位。
+// 180 横向：每 3 个源像素放大成 4 个（第一个重复），纵向按四舍五入取起点、向上取整取行数。
+// 纵向只有按 3 行对齐的起点和行数才和 band 落在同样的屏幕行上，所以 180 的瓦片 y、h 都要是 3 的倍数
+#define BAND_180_ROW_GROUP 3
+static inline int scale_dst_x(int res, int sx) {
+    switch (res) {
+        case BAND_RES_180: { int k = sx / 3, r = sx % 3; return 4 * k + (r ? r + 1 : 0); }
+        case BAND_RES_120: return sx * 2;
+        default: return sx;
+    }
+}
+
+static inline int scale_dst_y(int res, int sy) {
+    switch (res) {
+        case BAND_RES_180: return (sy * 240 + 120) / 180;
+        case BAND_RES_120: return sy * 2;
+        default: return sy;
+    }
+}
+
+static inline int scale_dst_h(int res, int h) {
+    switch (res) {
+        case BAND_RES_180: return (h * 240 + 179) / 180;
+        case BAND_RES_120: return h * 2;
+        default: return h;
+    }
+}
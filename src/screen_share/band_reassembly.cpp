@@ -0,0 +1,68 @@
+#include "band_reassembly.h"
+#include <string.h>
+
+BandReassembly::BandReassembly(FramePool& pool)
+    : bands(0), timeouts(0), noSlot(0), pool_(pool) {
+    for (int i = 0; i < BIG_SLOT_MAX; i++) {
+        e_[i].slot = -1;
+        e_[i].busy = false;
+    }
+}
+
+void BandReassembly::collect(uint32_t now_ms) {
+    for (int i = 0; i < BIG_SLOT_MAX; i++) {
+        Entry& e = e_[i];
+        if (e.busy && (now_ms - e.start_ms >= FRAG_TIMEOUT_MS || pool_.isStale(e.frame_id))) {
+            e.busy = false; // 槽位还拿着，下一个 band 接着用
+            timeouts++;
+        }
+    }
+}
+
+int BandReassembly::add(const FragHeader& h, const uint8_t* data, uint32_t len, uint32_t now_ms) {
+    collect(now_ms);
+
+    Entry* e = nullptr;
+    for (int i = 0; i < BIG_SLOT_MAX && !e; i++) {
+        if (e_[i].busy && e_[i].frame_id == h.frame_id && e_[i].y0 == h.y0) e = &e_[i];
+    }
+    if (!e) {
+        // 新的 band：先找手里空着的槽位，再去池子里拿
+        for (int i = 0; i < BIG_SLOT_MAX && !e; i++) {
+            if (!e_[i].busy && e_[i].slot >= 0) e = &e_[i];
+        }
+        for (int i = 0; i < BIG_SLOT_MAX && !e; i++) {
+            if (!e_[i].busy && e_[i].slot < 0 && (e_[i].slot = pool_.acquireBig()) >= 0) e = &e_[i];
+        }
+        if (!e) {
+            noSlot++;
+            return -1;
+        }
+        e->busy = true;
+        e->frame_id = h.frame_id;
+        e->y0 = h.y0;
+        e->count = h.count;
+        e->color = h.color;
+        e->lines = h.lines;
+        e->got = 0;
+        e->start_ms = now_ms;
+    }
+    if (h.count != e->count || h.color != e->color || h.lines != e->lines) {
+        e->busy = false; // 拼不出一个完整的 band，先到的分片也不要了
+        return REASM_BAD;
+    }
+    uint32_t bit = 1u << h.index;
+    if (e->got & bit) return -1; // 重复的分片
+
+    e->got |= bit;
+    uint8_t* buf = (uint8_t*)pool_.slots[e->slot].lines + dataOffset(h.color, h.lines);
+    memcpy(buf + h.offset, data, len);
+    uint32_t all = e->count == 32 ? 0xFFFFFFFFu : (1u << e->count) - 1;
+    if (e->got != all) return -1;
+
+    int slot = e->slot;
+    e->busy = false;
+    e->slot = -1; // 交给绘制线程了，下次重新拿
+    bands++;
+    return slot;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include "band_protocol.h"
+#include "frame_pool.h"
+
+#define FRAG_TIMEOUT_MS 30 // 半截 band 等这么久还没拼齐就丢掉
+#define REASM_BAD -2       // add 的返回值：分片和同一个 band 先到的分片对不上，整个 band 丢掉
+
+// ================= 分片重组 =================
+// 一个 16~32 行的大 band 放不进一个数据报，发送端拆成几个 BAND_PKT_FRAG 分片。
+// 每个正在拼的 band 占一个大槽位，分片按偏移直接拷进去，拼齐了由收包线程转成大端 RGB565 交给绘制线程，
+// 绘制线程一次 DMA 发 16~32 行，窗口命令和 DMA 次数都少了。
+// RGB332 的负载放在槽位后半段（偏移 = 像素数），转色时从前往后写不会盖掉没读的部分。
+// 超时或者帧已经过期的半截 band 由 tick（收包循环里）或者下一个分片回收，槽位留着给下一个 band 用
+// （收包线程不能往大槽位的空闲队列里放）。只在收包线程里调用
+class BandReassembly {
+public:
+    explicit BandReassembly(FramePool& pool);
+
+    // 收到一个分片（头部已经检查过）。拼齐了返回大槽位下标，负载在 slots[i].lines 里、还没转色，
+    // 颜色和行数以第一个分片为准；还没拼齐返回 -1；分片数/颜色/行数和先到的分片不一样返回 REASM_BAD
+    int add(const FragHeader& h, const uint8_t* data, uint32_t len, uint32_t now_ms);
+    // 回收超时或者过期的半截 band，收包循环里调用，没有新分片时槽位也不会一直占着
+    void tick(uint32_t now_ms) { collect(now_ms); }
+    // 负载在大槽位里的字节偏移
+    static uint32_t dataOffset(uint8_t color, int lines) {
+        return color == BAND_COLOR_RGB332 ? (uint32_t)IMG_W * lines : 0;
+    }
+
+    // 统计
+    volatile uint32_t bands;    // 拼好的 band
+    volatile uint32_t timeouts; // 超时或者过期丢掉的半截 band
+    volatile uint32_t noSlot;   // 大槽位都在用，丢掉的分片
+
+private:
+    struct Entry {
+        int slot;       // 拿到的大槽位，-1 表示还没有
+        bool busy;      // 正在拼
+        uint16_t frame_id;
+        uint8_t y0;
+        uint8_t count;
+        uint8_t color;
+        uint8_t lines;
+        uint32_t got;   // 收到的分片，第 i 位是第 i 片
+        uint32_t start_ms;
+    };
+
+    void collect(uint32_t now_ms);
+
+    FramePool& pool_;
+    Entry e_[BIG_SLOT_MAX];
+};
@@ -0,0 +1,651 @@
+#include "band_receiver.h"
+#include "band_codec.h"
+#include "jpeg_slice.h"
+#include "scale_function2.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 没有空槽位时用来把包收掉
+static uint8_t rxDropBuf[1472];
+
+BandReceiver::BandReceiver(BandTransport& transport, FramePool& pool)
+    : packets(0), bytes(0), dropNoSlot(0), dropLate(0), bad(0), tiles(0),
+      palettes(0), multis(0), multiBands(0), frags(0), dropNoPalette(0), retx(0), dropRetx(0), dropDup(0), lastReceiveMs(0), packetsTotal(0), dropsTotal(0),
+      nack(transport), reasm(pool),
+      transport_(transport), pool_(pool), spareLines_(nullptr),
+      decodeBuf_(nullptr), multiBuf_(nullptr), xorRef_(nullptr), xorRes_(0), xorBase_(0),
+      commitHook_(nullptr), commitUser_(nullptr) {
+    memset(pal_, 0, sizeof(pal_));
+}
+
+bool BandReceiver::begin() {
+    init_scale_maps();
+    spareLines_ = (uint16_t*)dma_alloc(SLOT_BYTES);
+    decodeBuf_ = (uint16_t*)malloc(SLOT_BYTES);
+    lastReceiveMs = millis();
+    return spareLines_ != nullptr && decodeBuf_ != nullptr;
+}
+
+// 参考帧按最大的 240x240 RGB565 申请；分辨率或像素格式变了就清零，等关键帧重新填
+uint8_t* BandReceiver::xorRef(uint8_t res, uint8_t base) {
+    if (!xorRef_) {
+        xorRef_ = (uint8_t*)malloc(IMG_W * IMG_H * 2);
+        if (!xorRef_) return nullptr;
+        memset(xorRef_, 0, IMG_W * IMG_H * 2);
+        xorRes_ = res;
+        xorBase_ = base;
+    }
+    if (res != xorRes_ || base != xorBase_) {
+        memset(xorRef_, 0, IMG_W * IMG_H * 2);
+        xorRes_ = res;
+        xorBase_ = base;
+    }
+    return xorRef_;
+}
+
+// 压缩 band 解码成源分辨率的大端 RGB565，写进 out。数据不对返回 false
+IRAM_ATTR bool BandReceiver::decodeBand(const BandHeader& h, int src_w, const uint8_t* in, uint32_t len, uint16_t* out) {
+    if (len < 1 || h.y0 + h.lines > src_w) return false;
+    uint8_t codec = in[0] >> 4;
+    uint8_t base = in[0] & 0x03;
+    bool key = (in[0] & BAND_CODEC_KEY) != 0;
+    if (base == BAND_COLOR_CODEC) return false;
+    int n = src_w * h.lines;
+
+    switch (codec) {
+    case BAND_CODEC_XOR: {
+        uint8_t* ref = xorRef(h.res, base);
+        if (!ref) return false;
+        int bpp = band_bytes_per_px(base);
+        ref += h.y0 * src_w * bpp;
+        if (key) memset(ref, 0, n * bpp);
+        return xor_delta_decode(in + 1, len - 1, ref, base, n, out);
+    }
+    case BAND_CODEC_RLE:
+        return packbits_decode(in + 1, len - 1, base, n, out);
+    case BAND_CODEC_QOI:
+        return base != BAND_COLOR_RGB332 && qoi565_decode(in + 1, len - 1, n, out);
+    case BAND_CODEC_JPEG:
+        return jpeg_slice_decode(in + 1, len - 1, src_w, h.lines, out);
+    default:
+        return false;
+    }
+}
+
+// 过期帧的包丢掉，否则记下已经开始的最新帧
+bool BandReceiver::acceptFrame(uint16_t frame_id) {
+    if (pool_.isStale(frame_id)) {
+        dropLate++;
+        dropsTotal++;
+        return false;
+    }
+    pool_.noteFrame(frame_id);
+    return true;
+}
+
+// 转换结果在 spareLines 里的话和槽位交换指针，然后交给绘制线程
+void BandReceiver::commit(FrameData* f, uint16_t* dst, uint16_t frame_id,
+                          int x, int y, int w, int h) {
+    if (dst != f->lines) {
+        spareLines_ = f->lines;
+        f->lines = dst;
+    }
+    f->frame_id = frame_id;
+    f->x_start = x;
+    f->y_start = y;
+    f->width = w;
+    f->line_count = h;
+    pool_.commit();
+    if (commitHook_) commitHook_(commitUser_);
+}
+
+// ================= v2 瓦片 =================
+IRAM_ATTR void BandReceiver::processTile(const uint8_t* header, FrameData* f, uint32_t payload) {
+    // 瓦片头比 band 头多 3 字节，收包时落在了槽位开头
+    const uint32_t extra = TILE_HEADER_BYTES - BAND_HEADER_BYTES;
+    if (payload < extra) {
+        bad++;
+        return;
+    }
+    uint8_t th[TILE_HEADER_BYTES];
+    memcpy(th, header, BAND_HEADER_BYTES);
+    memcpy(th + BAND_HEADER_BYTES, f->lines, extra);
+    TileHeader t;
+    band_parse_tile_header(th, t);
+
+    int size = band_src_size(t.res);
+    if (size == 0 || t.color == 3 || t.w == 0 || t.h == 0 ||
+        t.x + t.w > size || t.y + t.h > size ||
+        (t.res == BAND_RES_180 && (t.y % BAND_180_ROW_GROUP || t.h % BAND_180_ROW_GROUP))) {
+        bad++;
+        return;
+    }
+    uint32_t expect = t.w * t.h * band_bytes_per_px(t.color);
+    if (payload - extra < expect) {
+        bad++;
+        return;
+    }
+    // 屏幕上的矩形，放大后要放得进一个槽位
+    int dx = scale_dst_x(t.res, t.x);
+    int dw = scale_dst_x(t.res, t.x + t.w) - dx;
+    int dy = scale_dst_y(t.res, t.y);
+    int dh = scale_dst_h(t.res, t.h);
+    if (dy + dh > IMG_H) dh = IMG_H - dy;
+    if (dw * dh * 2 > SLOT_BYTES || dh <= 0) {
+        bad++;
+        return;
+    }
+    // 瓦片只在内容变化时发一次，被新帧取代了也要画，不然这块区域就一直是旧的
+    pool_.noteFrame(t.frame_id);
+    tiles++;
+
+    // 像素挪到槽位开头，对齐后 240 + RGB565 仍然可以零拷贝
+    uint8_t* rxBuf = (uint8_t*)f->lines;
+    memmove(rxBuf, rxBuf + extra, expect);
+
+    uint16_t* dst = spareLines_;
+    if (t.res == BAND_RES_240) {
+        if (t.color == BAND_COLOR_RGB332) {
+            rgb332_to_565be(rxBuf, dst, t.w * t.h);
+        } else {
+            dst = f->lines; // 零拷贝
+            if (t.color == BAND_COLOR_RGB565) {
+                rgb565_to_be_inplace(dst, t.w * t.h);
+            }
+        }
+    } else if (t.res == BAND_RES_180) {
+        scale_tile_180_to_240_be(rxBuf, t.color, t.x, t.w, t.h, dst, dx, dw, dh);
+    } else {
+        scale_tile_120_to_240_be(rxBuf, t.color, t.w, t.h, dst);
+    }
+    commit(f, dst, t.frame_id, dx, dy, dw, dh);
+}
+
+// ================= 调色板 =================
+// 同一帧的调色板覆盖，否则替换两个里较旧的那个；比两个都旧的不要
+IRAM_ATTR void BandReceiver::processPalette(const uint8_t* header, FrameData* f, uint32_t payload) {
+    PaletteHeader p;
+    band_parse_palette_header(header, p);
+    if (payload < p.entries * 2u) {
+        bad++;
+        return;
+    }
+    if (!acceptFrame(p.frame_id)) {
+        return;
+    }
+    palettes++;
+    Palette* dst = nullptr;
+    for (int i = 0; i < 2; i++) {
+        if (pal_[i].valid && pal_[i].frame_id == p.frame_id) dst = &pal_[i];
+    }
+    if (!dst) {
+        if (!pal_[0].valid) dst = &pal_[0];
+        else if (!pal_[1].valid) dst = &pal_[1];
+        else dst = frame_newer(pal_[0].frame_id, pal_[1].frame_id) ? &pal_[1] : &pal_[0];
+        if (dst->valid && frame_newer(dst->frame_id, p.frame_id)) return;
+    }
+    // 包里就是屏幕字节序，直接拷；没给的项是黑色
+    memcpy(dst->lut, f->lines, p.entries * 2);
+    memset(dst->lut + p.entries, 0, (256 - p.entries) * 2);
+    dst->frame_id = p.frame_id;
+    dst->version = p.version;
+    dst->valid = true;
+}
+
+// ================= 多 band 包 =================
+// 包和 multiBuf 交换指针挪出槽位，然后每个子 band 拷进一个槽位，和单独收到的 band 走同一条路（FEC/NACK 也一样）
+IRAM_ATTR void BandReceiver::processMulti(const uint8_t* header, FrameData* f, uint32_t payload) {
+    uint8_t count = header[3];
+    if (count == 0) {
+        bad++;
+        return;
+    }
+    if (!multiBuf_) {
+        multiBuf_ = (uint16_t*)dma_alloc(SLOT_BYTES);
+        if (!multiBuf_) {
+            bad++;
+            return;
+        }
+    }
+    uint16_t* in = f->lines;
+    f->lines = multiBuf_;
+    multiBuf_ = in;
+    multis++;
+
+    const uint8_t* p = (const uint8_t*)in;
+    uint32_t off = 0;
+    for (int i = 0; i < count; i++) {
+        if (payload - off < MULTI_SUB_HEADER_BYTES) {
+            bad++;
+            return;
+        }
+        uint8_t h[BAND_HEADER_BYTES];
+        h[0] = header[0];
+        h[1] = header[1];
+        h[2] = 0;
+        h[3] = p[off];
+        h[4] = p[off + 1];
+        uint32_t len = (p[off + 2] << 8) | p[off + 3];
+        off += MULTI_SUB_HEADER_BYTES;
+        if (len > payload - off) {
+            bad++;
+            return;
+        }
+        FrameData* slot = pool_.acquire();
+        if (!slot) {
+            dropNoSlot += count - i;
+            dropsTotal += count - i;
+            return;
+        }
+        memcpy(slot->lines, p + off, len);
+        off += len;
+        multiBands++;
+        fec.addBand(h, (const uint8_t*)slot->lines, len);
+        processPacket(h, slot, len);
+        if (fec.ready()) {
+            recoverBand();
+        }
+    }
+}
+
+// ================= 分片 =================
+// 分片拷进大槽位，拼齐了就地转成大端 RGB565，整个大槽位交给绘制线程。收分片用的普通槽位留给下一个包
+IRAM_ATTR void BandReceiver::processFragment(const uint8_t* header, FrameData* f, uint32_t payload) {
+    const uint32_t extra = FRAG_HEADER_BYTES - BAND_HEADER_BYTES;
+    if (payload < extra) {
+        bad++;
+        return;
+    }
+    uint8_t fh[FRAG_HEADER_BYTES];
+    memcpy(fh, header, BAND_HEADER_BYTES);
+    memcpy(fh + BAND_HEADER_BYTES, f->lines, extra);
+    FragHeader h;
+    band_parse_frag_header(fh, h);
+    uint32_t len = payload - extra;
+    int n = IMG_W * h.lines;
+    if (h.res != BAND_RES_240 || h.color == BAND_COLOR_CODEC || h.lines == 0 || h.lines > FRAG_MAX_LINES ||
+        h.y0 + h.lines > IMG_H || h.count == 0 || h.count > FRAG_MAX_COUNT || h.index >= h.count ||
+        h.offset + len > (uint32_t)n * band_bytes_per_px(h.color)) {
+        bad++;
+        return;
+    }
+    if (!acceptFrame(h.frame_id)) {
+        return;
+    }
+    frags++;
+    if (nack.delivered(h.frame_id, IMG_W, h.y0, h.lines)) {
+        // 这个 band 已经拼齐交出去了，后面到的是重复的分片
+        dropDup++;
+        return;
+    }
+    int idx = reasm.add(h, (const uint8_t*)f->lines + extra, len, lastReceiveMs);
+    if (idx == REASM_BAD) {
+        bad++;
+        return;
+    }
+    if (idx < 0) {
+        return;
+    }
+    FrameData* big = &pool_.slots[idx];
+    if (h.color == BAND_COLOR_RGB332) {
+        rgb332_to_565be((const uint8_t*)big->lines + BandReassembly::dataOffset(h.color, h.lines), big->lines, n);
+    } else if (h.color == BAND_COLOR_RGB565) {
+        rgb565_to_be_inplace(big->lines, n);
+    }
+    nack.onBand(h.frame_id, IMG_W, h.y0, h.lines, lastReceiveMs);
+    big->frame_id = h.frame_id;
+    big->x_start = 0;
+    big->y_start = h.y0;
+    big->width = IMG_W;
+    big->line_count = h.lines;
+    pool_.commitBig(idx);
+    if (commitHook_) commitHook_(commitUser_);
+}
+
+// 先找这一帧的调色板；没到（丢了或者 band 先到）就找版本号低 2 位一样的，内容是一样的
+const uint16_t* BandReceiver::paletteFor(uint16_t frame_id, uint8_t version) {
+    const Palette* match = nullptr;
+    for (int i = 0; i < 2; i++) {
+        const Palette& p = pal_[i];
+        if (!p.valid) continue;
+        if (p.frame_id == frame_id) return p.lut;
+        if ((p.version & 0x03) == version && (!match || frame_newer(p.frame_id, match->frame_id))) match = &p;
+    }
+    return match ? match->lut : nullptr;
+}
+
+// 调色板 band 不经过 decodeBuf，索引直接查表、放大进 spareLines
+IRAM_ATTR void BandReceiver::processPaletteBand(const BandHeader& h, int src_w, FrameData* f, uint32_t payload) {
+    const uint8_t* in = (const uint8_t*)f->lines;
+    bool pal4 = (in[0] >> 4) == BAND_CODEC_PAL4;
+    int src_lines = h.lines;
+    uint32_t expect = 1 + (pal4 ? src_w * src_lines / 2 : src_w * src_lines);
+    if (payload < expect || h.y0 + src_lines > src_w) {
+        bad++;
+        return;
+    }
+    const uint16_t* pal = paletteFor(h.frame_id, in[0] & 0x03);
+    if (!pal) {
+        dropNoPalette++; // 画错颜色不如不画，下一帧会补上
+        return;
+    }
+    in++;
+
+    uint16_t* dst = spareLines_;
+    int dst_y0 = scale_dst_y(h.res, h.y0);
+    int dst_lines = scale_dst_h(h.res, src_lines);
+    if (src_w == 240) {
+        if (pal4) pal4_to_565be(in, pal, dst, src_w * src_lines);
+        else pal8_to_565be(in, pal, dst, src_w * src_lines);
+    } else if (src_w == 180) {
+        if (dst_lines > RGB_LINE_BATCH) {
+            bad++;
+            return;
+        }
+        if (dst_y0 + dst_lines > IMG_H) dst_lines = IMG_H - dst_y0; // 和不压缩的 180 一样截掉越界的行
+        if (pal4) scale_180_to_240_pal4_be(in, pal, dst, src_lines);
+        else scale_180_to_240_pal8_be(in, pal, dst, src_lines);
+    } else {
+        // 和不压缩的 120 一样，超过一个槽位的行数截掉
+        if (dst_lines > RGB_LINE_BATCH) {
+            src_lines = RGB_LINE_BATCH / 2;
+            dst_lines = RGB_LINE_BATCH;
+        }
+        if (pal4) scale_120_to_240_pal4_be(in, pal, dst, src_lines);
+        else scale_120_to_240_pal8_be(in, pal, dst, src_lines);
+    }
+    commit(f, dst, h.frame_id, 0, dst_y0, IMG_W, dst_lines);
+}
+
+// YUV 和调色板一样，转色和放大在同一个函数里做完，不经过 decodeBuf
+IRAM_ATTR void BandReceiver::processYuvBand(const BandHeader& h, int src_w, FrameData* f, uint32_t payload) {
+    const uint8_t* in = (const uint8_t*)f->lines;
+    int src_lines = h.lines;
+    if (payload < 1 + band_yuv420_bytes(src_w, src_lines) || h.y0 + src_lines > src_w) {
+        bad++;
+        return;
+    }
+    // 三个平面按这个 band 实际的行数排，120 截掉行数也不影响
+    const uint8_t* y = in + 1;
+    const uint8_t* u = y + src_w * src_lines;
+    const uint8_t* v = u + (src_w / 2) * ((src_lines + 1) / 2);
+
+    uint16_t* dst = spareLines_;
+    int dst_y0 = scale_dst_y(h.res, h.y0);
+    int dst_lines = scale_dst_h(h.res, src_lines);
+    if (src_w == 240) {
+        yuv420_to_565be(y, u, v, dst, src_w, src_lines);
+    } else if (src_w == 180) {
+        if (dst_lines > RGB_LINE_BATCH) {
+            bad++;
+            return;
+        }
+        if (dst_y0 + dst_lines > IMG_H) dst_lines = IMG_H - dst_y0;
+        scale_180_to_240_yuv420_be(y, u, v, dst, src_lines);
+    } else {
+        if (dst_lines > RGB_LINE_BATCH) {
+            src_lines = RGB_LINE_BATCH / 2;
+            dst_lines = RGB_LINE_BATCH;
+        }
+        scale_120_to_240_yuv420_be(y, u, v, dst, src_lines);
+    }
+    commit(f, dst, h.frame_id, 0, dst_y0, IMG_W, dst_lines);
+}
+
+IRAM_ATTR bool BandReceiver::poll() {
+    reasm.tick(millis());
+
+    // 先拿槽位再收包：头部读进 header，负载直接落进槽位
+    uint8_t header[BAND_HEADER_BYTES];
+    FrameData* f = pool_.acquire();
+    bool truncated = false;
+    int packetSize = transport_.recv(header, sizeof(header),
+                                     f ? (uint8_t*)f->lines : rxDropBuf,
+                                     f ? SLOT_BYTES : sizeof(rxDropBuf),
+                                     &truncated);
+    if (packetSize <= 0) {
+        return false;
+    }
+    packets++;
+    packetsTotal++;
+    bytes += packetSize;
+    lastReceiveMs = millis();
+
+    if (!f) {
+        dropNoSlot++;
+        dropsTotal++;
+        return true;
+    }
+
+    // ------------------ 读 Header ------------------
+    if (packetSize < (int)sizeof(header) || truncated) {
+        bad++;
+        return true; // 处理了一个包但失败了，槽位留着给下一个包
+    }
+    uint32_t payload = packetSize - sizeof(header);
+
+    // FEC 要在处理之前把负载异或进去，处理时负载会被就地转换
+    if (!band_is_ext(header)) {
+        fec.addBand(header, (const uint8_t*)f->lines, payload);
+    }
+    processPacket(header, f, payload);
+    if (fec.ready()) {
+        recoverBand();
+    }
+    return true;
+}
+
+// 校验包补回来的 band 和收到的一样处理，要另外拿一个槽位
+void BandReceiver::recoverBand() {
+    FrameData* f = pool_.acquire();
+    if (!f) {
+        fec.discardRecovered();
+        dropNoSlot++;
+        dropsTotal++;
+        return;
+    }
+    uint8_t header[BAND_HEADER_BYTES];
+    int payload = fec.takeRecovered(header, (uint8_t*)f->lines, SLOT_BYTES);
+    if (payload >= 0) {
+        processPacket(header, f, payload);
+    }
+}
+
+IRAM_ATTR void BandReceiver::processPacket(const uint8_t* header, FrameData* f, uint32_t payload) {
+    if (band_is_ext(header)) {
+        if (band_ext_type(header) == BAND_PKT_TILE) {
+            processTile(header, f, payload);
+        } else if (band_ext_type(header) == BAND_PKT_PALETTE) {
+            processPalette(header, f, payload);
+        } else if (band_ext_type(header) == BAND_PKT_FRAG) {
+            processFragment(header, f, payload);
+        } else if (band_ext_type(header) == BAND_PKT_MULTI) {
+            processMulti(header, f, payload);
+        } else if (band_ext_type(header) == BAND_PKT_PARITY) {
+            if (!fec.addParity(header, (const uint8_t*)f->lines, payload)) bad++;
+        } else {
+            bad++;
+        }
+        return;
+    }
+
+    BandHeader h;
+    band_parse_header(header, h);
+    int src_lines = h.lines;
+
+    if (src_lines == 0 || src_lines > RGB_LINE_BATCH) {
+        bad++;
+        return;
+    }
+    bool is_rgb565 = (h.color != BAND_COLOR_RGB332);
+    bool is_rgb565_be = (h.color == BAND_COLOR_RGB565_BE);
+    bool decoded = (h.color == BAND_COLOR_CODEC);
+
+    // ------------------ 源尺寸 ------------------
+    int src_w = band_src_size(h.res);
+    if (src_w == 0) {
+        bad++;
+        return;
+    }
+    // y0 最多有 14 位，越界的 band 不能进绘制线程和完成统计
+    if (h.y0 + src_lines > src_w) {
+        bad++;
+        return;
+    }
+
+    // ------------------ 过期帧 ------------------
+    if (h.retx) {
+        retx++;
+        if (h.y0 >= src_w || nack.covered(h.frame_id, src_w, h.y0, src_lines)) {
+            dropRetx++;
+            return;
+        }
+    } else if (nack.delivered(h.frame_id, src_w, h.y0, src_lines)) {
+        // 网络复制出来的同一个 band，画两遍会多占 SPI，XOR 增量还会被重复应用
+        dropDup++;
+        return;
+    }
+    if (!acceptFrame(h.frame_id)) {
+        return;
+    }
+    nack.onBand(h.frame_id, src_w, h.y0, src_lines, lastReceiveMs);
+
+    // 负载已经在槽位里，240 + RGB565 不需要再搬运
+    uint8_t* rxBuf = (uint8_t*)f->lines;
+    uint16_t* dst = spareLines_;
+
+    if (decoded && payload >= 1) {
+        uint8_t codec = rxBuf[0] >> 4;
+        if (codec == BAND_CODEC_PAL4 || codec == BAND_CODEC_PAL8) {
+            processPaletteBand(h, src_w, f, payload);
+            return;
+        }
+        if (codec == BAND_CODEC_YUV420) {
+            processYuvBand(h, src_w, f, payload);
+            return;
+        }
+    }
+
+    if (decoded) {
+        // ------------------ 解码 ------------------
+        // 240 直接解到 spareLines；180/120 解到 decodeBuf，后面当大端 RGB565 放大
+        uint16_t* out = (src_w == IMG_W) ? spareLines_ : decodeBuf_;
+        if (!decodeBand(h, src_w, rxBuf, payload, out)) {
+            bad++;
+            return;
+        }
+        rxBuf = (uint8_t*)out;
+        is_rgb565 = true;
+        is_rgb565_be = true;
+    } else {
+        // ------------------ 计算接收大小 ------------------
+        uint32_t expect = src_w * src_lines * band_bytes_per_px(h.color);
+        if (payload < expect) {
+            bad++;
+            return;
+        }
+    }
+
+    // =================================================
+    //            分辨率统一 → 240 RGB565
+    // =================================================
+    int dst_y0 = 0;
+    int dst_lines = 0;
+
+    // =============== 240 → 240 ======================
+    if (src_w == 240) {
+        dst_y0 = h.y0;
+        dst_lines = src_lines;
+        
+        if (decoded) {
+            // 已经解码成大端，就在 spareLines 里
+        } else if (is_rgb565) {
+            dst = f->lines; // 零拷贝
+            if (!is_rgb565_be) {
+                rgb565_to_be_inplace(dst, 240 * src_lines);
+            }
+        } else {
+            rgb332_to_565be(rxBuf, dst, src_w * src_lines);
+        }
+    }
+    // =============== 180 → 240 ======================
+    else if (src_w == 180) {
+        // 计算目标行范围
+        dst_y0 = (h.y0 * 240 + 120) / 180;  // 四舍五入
+        dst_lines = (src_lines * 240 + 179) / 180; // 向上取整
+        // 检查缓冲区是否足够
+        if (dst_lines > RGB_LINE_BATCH) {
+            bad++;
+            return;
+        }
+        // 最后一个 band 四舍五入后可能超出 240 行，多出来的行不发（屏幕会拒绝越界的窗口）
+        if (dst_y0 + dst_lines > IMG_H) {
+            dst_lines = IMG_H - dst_y0;
+        }
+        if (dst_lines <= 0) {
+            bad++;
+            return;
+        }
+        if (is_rgb565_be) {
+            scale_180_to_240_rgb565(
+                (uint16_t*)rxBuf,
+                dst,
+                src_lines
+            );
+        } else if (is_rgb565) {
+            scale_180_to_240_rgb565_be(
+                (uint16_t*)rxBuf,
+                dst,
+                src_lines
+            );
+        } else {
+            scale_180_to_240_rgb332_be(
+                rxBuf,
+                dst,
+                src_lines
+            );
+        }
+    }
+    // =============== 120 → 240 ======================
+    else if (src_w == 120) {
+        // 计算目标行范围
+        dst_y0 = h.y0 * 2;
+        dst_lines = src_lines * 2;
+        // 确保不超出240边界
+        if (dst_y0 + dst_lines > 240) {
+            dst_lines = 240 - dst_y0;
+        }
+        if (dst_lines <= 0) {
+            bad++;
+            return;
+        }
+
+        // 检查缓冲区是否足够
+        if (dst_lines > RGB_LINE_BATCH) {
+            // 如果超出，调整接收到的行数
+            int max_src_lines = RGB_LINE_BATCH / 2;
+            if (src_lines > max_src_lines) {
+                src_lines = max_src_lines;
+                dst_lines = max_src_lines * 2;
+            }
+        }
+
+        if (is_rgb565_be) {
+            scale_120_to_240_rgb565((uint16_t*)rxBuf,
+            dst,
+            src_lines);
+        } else if (is_rgb565) {
+            scale_120_to_240_rgb565_be((uint16_t*)rxBuf,
+            dst,
+            src_lines);
+        } else {
+            scale_120_to_240_rgb332_be(
+                (uint8_t*)rxBuf,
+                dst,
+                src_lines);
+        }
+    }
+
+    // ------------------ 提交 ------------------
+    commit(f, dst, h.frame_id, 0, dst_y0, IMG_W, dst_lines);
+}
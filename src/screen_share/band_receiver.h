@@ -0,0 +1,93 @@
+#pragma once
+#include "frame_pool.h"
+#include "band_transport.h"
+#include "band_protocol.h"
+#include "band_fec.h"
+#include "band_nack.h"
+#include "band_reassembly.h"
+
+// ================= 收包 → 槽位 =================
+// 从 transport 收 band，解析头部，负载直接落进槽位，缩放/转色成 240 宽大端 RGB565 后提交给绘制线程。
+// 只在收包线程里调用
+class BandReceiver {
+public:
+    BandReceiver(BandTransport& transport, FramePool& pool);
+
+    // 分配转换用的缓冲区、初始化缩放表，失败返回 false
+    bool begin();
+
+    // 收一个包并处理，没有包返回 false
+    bool poll();
+
+    // 每次提交 band 后调用，用来唤醒绘制线程
+    void setCommitHook(void (*fn)(void*), void* user) {
+        commitHook_ = fn;
+        commitUser_ = user;
+    }
+
+    // 统计，调试输出读完可以直接清零
+    volatile uint32_t packets;
+    volatile uint32_t bytes;        // 收到的字节数（含头部）
+    volatile uint32_t dropNoSlot;   // 没有空槽位丢掉的包
+    volatile uint32_t dropLate;     // 帧已经被更新的帧取代，到了就丢
+    volatile uint32_t bad;          // 头部/长度不对的包
+    volatile uint32_t tiles;        // 其中的瓦片包
+    volatile uint32_t palettes;     // 其中的调色板包
+    volatile uint32_t multis;       // 其中的多 band 包
+    volatile uint32_t multiBands;   // 多 band 包里拆出来的 band
+    volatile uint32_t frags;        // 其中的分片
+    volatile uint32_t dropNoPalette; // 调色板没到、旧调色板版本也对不上的 band
+    volatile uint32_t retx;         // 收到的重发 band
+    volatile uint32_t dropRetx;     // 其中到得太晚、那几行已经被画过的
+    volatile uint32_t dropDup;      // 同一帧同样的行已经收过的 band，网络复制出来的
+    volatile uint32_t lastReceiveMs;
+    // packets、dropNoSlot+dropLate 的累计值，不清零，反馈包按差值算
+    volatile uint32_t packetsTotal;
+    volatile uint32_t dropsTotal;
+    // 收到过校验包之后自动开始用，计数器在里面
+    BandFec fec;
+    // setDelay 之后才发 NACK；重发的 band 不管开没开都按它判断要不要
+    BandNack nack;
+    // 分片拼成的大 band 放进 pool 的大槽位，没有调 pool.beginBig 时分片全部丢掉
+    BandReassembly reasm;
+
+private:
+    void processPacket(const uint8_t* header, FrameData* f, uint32_t payload);
+    void recoverBand();
+    bool acceptFrame(uint16_t frame_id);
+    void processTile(const uint8_t* header, FrameData* f, uint32_t payload);
+    bool decodeBand(const BandHeader& h, int src_w, const uint8_t* in, uint32_t len, uint16_t* out);
+    void processPalette(const uint8_t* header, FrameData* f, uint32_t payload);
+    void processMulti(const uint8_t* header, FrameData* f, uint32_t payload);
+    void processFragment(const uint8_t* header, FrameData* f, uint32_t payload);
+    void processPaletteBand(const BandHeader& h, int src_w, FrameData* f, uint32_t payload);
+    void processYuvBand(const BandHeader& h, int src_w, FrameData* f, uint32_t payload);
+    const uint16_t* paletteFor(uint16_t frame_id, uint8_t version);
+    uint8_t* xorRef(uint8_t res, uint8_t base);
+    void commit(FrameData* f, uint16_t* dst, uint16_t frame_id,
+                int x, int y, int w, int h);
+
+    BandTransport& transport_;
+    FramePool& pool_;
+    // 需要缩放或转色的包：负载先读进槽位，转换结果写进 spareLines，再交换两边的指针。
+    // spareLines 只归收包线程使用
+    uint16_t* spareLines_;
+    // 压缩的 180/120 band 先解码到这里再放大
+    uint16_t* decodeBuf_;
+    // 多 band 包整个换到这里再拆，第一次收到时才申请，和槽位交换指针所以也是 DMA 内存
+    uint16_t* multiBuf_;
+    // XOR 增量的参考帧：源分辨率、线上像素格式，第一次收到 XOR 包时才申请
+    uint8_t* xorRef_;
+    uint8_t xorRes_;
+    uint8_t xorBase_;
+    // 最近两帧的调色板（大端 RGB565），band 按帧号找，找不到再按版本号找
+    struct Palette {
+        bool valid;
+        uint16_t frame_id;
+        uint8_t version;
+        uint16_t lut[256];
+    };
+    Palette pal_[2];
+    void (*commitHook_)(void*);
+    void* commitUser_;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ================= band 数据报的收包接口 =================
+// 收包循环只依赖这个接口，ESP32 上是 lwIP socket，PC 上是 BSD socket，
+// 以后也可以换成回放文件或者模拟丢包的实现。
+// 所有函数都只在收包线程里调用。
+class BandTransport {
+public:
+    virtual ~BandTransport() {}
+
+    virtual bool begin(uint16_t port) = 0;
+    virtual void end() {}
+
+    // 阻塞到有数据报可读为止，超时返回 false
+    virtual bool wait(uint32_t timeout_ms) = 0;
+
+    // 非阻塞收一个数据报：前 hdr_len 字节进 hdr，剩下的直接进 payload（一般就是槽位）。
+    // 返回数据报总长度，没有数据返回 0，出错返回 -1。
+    // payload 放不下时 *truncated 置 true，多出来的部分被丢掉
+    virtual int recv(uint8_t* hdr, size_t hdr_len,
+                     uint8_t* payload, size_t payload_cap, bool* truncated) = 0;
+
+    // 发一个数据报给最近一次 recv 到的包的来源（反馈包用）。还没收到过包或者不支持返回 false
+    virtual bool reply(const uint8_t* data, size_t len) {
+        (void)data;
+        (void)len;
+        return false;
+    }
+};
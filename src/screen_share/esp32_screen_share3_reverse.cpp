@@ -1,225 +1,60 @@
 #include <WiFi.h>
-#include <WiFiUdp.h>
 #include "common.h"
-#include "scale_function2.h"
 #include "network_config.h"
+#include "socket_transport.h"
+#include "frame_pool.h"
+#include "band_receiver.h"
+#include "band_drawer.h"
+#include "band_feedback.h"
+#include "tft_panel.h"
 // 本代码是screen share一种实验：把绘制线程放入了core1的xTask,而udp线程放进loop，画面撕裂感大幅度下降，吞吐率1500-1600pac/s
+// 收包/槽位/缩放/绘制调度都在独立模块里，PC 上的 env:native 用的是同一份代码（见 src/host）
 // ================= WiFi =================
 const char* ssid = WIFI_SSID_STR;
 const char* password = WIFI_PASSWORD_STR;
 
-WiFiUDP udp;
 #define UDP_PORT 8888
+#define UDP_RCVBUF (32 * 1024) // 约 20 个 240 行 band，兜住绘制抢占收包线程时的突发
+#define UDP_DRAIN_MAX 32       // 每次唤醒最多收多少个包，收完再回去检查省电模式
+
+// 1: 收包阻塞在 select 上、提交 band 后通知绘制任务；0: 旧的轮询方式，用来对比延迟直方图
+#define PIPELINE_EVENT_DRIVEN 1
+#define UDP_WAIT_MS 100       // select 超时，只是为了定期检查省电模式
+#define DRAW_IDLE_WAIT_MS 100 // 绘制任务没活时最多睡多久
+static TaskHandle_t drawTaskHandle = nullptr;
+
+#define DMA_QUEUE_DEPTH 8 // 同时挂在 SPI 上的 band 数，绘制线程可以边发送边处理下一个
+
+// 整帧显示：0 = 流式(默认，延迟最低)；(0,1] = 收到这么多比例的行才显示，消除撕裂。
+// 需要额外 115KB 内存做后台缓冲
+#define PRESENT_FRACTION 0
+#define PRESENT_DEADLINE_MS 50 // 整帧模式下一帧最多等多久
+
+// 1: 新帧开始后，旧帧还没画的 band 直接回收、迟到的 band 到了就丢；0: 所有 band 都画
+#define EVICT_STALE_BANDS 1
+
+// 每隔这么久把收包/丢包/空闲槽位/绘制速度发回发送端，发送端用来自动调速；0: 不发
+#define FEEDBACK_INTERVAL_MS 100
+// >0: 当前帧缺的行等这么久还没到就发 NACK 让发送端重发（发送端要支持，见 band_nack.h）；0: 不发
+#define NACK_DELAY_MS 0
+// >0: 多申请这么多个 32 行的大槽位（每个 15KB DMA 内存），收发送端拆成分片的 16~32 行大 band；0: 分片直接丢
+#define BIG_SLOTS 0
+
+static SocketTransport transport(UDP_RCVBUF);
+static FramePool pool;
+static BandReceiver receiver(transport, pool);
+static BandFeedback feedback(transport, pool);
+static TftPanel* panel = nullptr; // tft 在 common.cpp 里 new 出来，setup 里再包一层
+static BandDrawer* drawer = nullptr;
 
-// ================= Image =================
-#define IMG_W 240
-#define RGB_LINE_BATCH 8  // 需要足够大，因为放大后行数可能增加
-
-// ================= Frame Buffer =================
-#define FRAME_BUF_COUNT 12 // 214492
-
-enum BufState {
-    BUF_FREE,
-    BUF_FILLING,
-    BUF_READY,
-    BUF_DISPLAYING
-};
-
-struct FrameData {
-    uint16_t frame_id;// = (header[0] << 8) | header[1];
-    uint16_t y_start;
-    uint16_t line_count;
-    uint16_t lines[IMG_W * RGB_LINE_BATCH];
-    volatile BufState state;
-};
-
-FrameData frameBuf[FRAME_BUF_COUNT];
-
-// ================= DMA =================
-uint16_t* dmaBuf[2];
-volatile uint8_t dmaSel = 0;
-
-// ================= Stats =================
-volatile uint32_t frameCount = 0;
-volatile uint32_t dropCount = 0;
-volatile uint32_t udpPackets = 0;
 DRAM_ATTR bool power_save_mode = false;
-unsigned long last_receive_time = millis();
-
-// ================= UDP Receiver Function =================
-IRAM_ATTR  bool processUDPPacket() {
-
-    static uint8_t rxBuf[1460];
-    int packetSize = udp.parsePacket();
-    if (packetSize <= 0) {
-        if(millis() - last_receive_time > 5000)  // 超过5秒没收到数据，进入省电模式
-        {  
-            power_save_mode = true;
-            delay(10);
-
-        }
-        return false;
-    }
-    udpPackets++;
-    last_receive_time = millis();
-    power_save_mode = false;
-
-    // ------------------ 读 Header ------------------
-    uint8_t header[5];
-    if (udp.read(header, 5) != 5) {
-        udp.flush();
-        return true; // 处理了一个包但失败了
-    }
-
-    uint16_t frame_id = (header[0] << 8) | header[1];
-    uint16_t src_y0 = (header[2] << 8) | header[3];
-    uint8_t flags = header[4];
-
-    uint8_t resolution = (flags >> 6) & 0x03; // 0=240,1=180,2=120
-    uint8_t color_mode = (flags >> 4) & 0x03; // 0=RGB565,1=RGB332
-    uint8_t src_lines = flags & 0x0F;
-
-    if (src_lines == 0 || src_lines > RGB_LINE_BATCH) {
-        udp.flush();
-        return true;
-    }
-    power_save_mode = false;
-
-    bool is_rgb565 = (color_mode == 0);
-
-    // ------------------ 源尺寸 ------------------
-    int src_w, src_h;
-    switch (resolution) {
-        case 0: src_w = src_h = 240; break;
-        case 1: src_w = src_h = 180; break;
-        case 2: src_w = src_h = 120; break;
-        default:
-            udp.flush();
-            return true;
-    }
-
-    // ------------------ 计算接收大小 ------------------
-    uint32_t bytes_per_px = is_rgb565 ? 2 : 1;
-    uint32_t expect = src_w * src_lines * bytes_per_px;
-
-    // ------------------ 找空 buffer ------------------
-    FrameData* f = nullptr;
-    for (int i = 0; i < FRAME_BUF_COUNT; i++) {
-        if (frameBuf[i].state == BUF_FREE) {
-            f = &frameBuf[i];
-            f->state = BUF_FILLING;
-            break;
-        }
-    }
-
-    if (!f) {
-        dropCount++;
-        udp.flush();
-        return true;
-    }
-
-    if (udp.read(rxBuf, expect) != expect) {
-        f->state = BUF_FREE;
-        return true;
-    }
-
-    // =================================================
-    //            分辨率统一 → 240 RGB565
-    // =================================================
-    uint16_t* dst = f->lines;
-    int dst_y0 = 0;
-    int dst_lines = 0;
-
-    // =============== 240 → 240 ======================
-    if (src_w == 240) {
-        dst_y0 = src_y0;
-        dst_lines = src_lines;
-        
-        if (is_rgb565) {
-            memcpy(dst, rxBuf, 240 * src_lines * 2);
-        } else {
-            int n = src_w * src_lines;
-            uint16_t* d = dst;
-            uint8_t* src = rxBuf;
-            while (n >= 4) {
-                d[0] = rgb332_to_565_lut[src[0]];
-                d[1] = rgb332_to_565_lut[src[1]];
-                d[2] = rgb332_to_565_lut[src[2]];
-                d[3] = rgb332_to_565_lut[src[3]];
-                src += 4;
-                d   += 4;
-                n   -= 4;
-            }   
-            while (n--) {
-                *d++ = rgb332_to_565_lut[*src++];
-            }
-        }
-    }
-    // =============== 180 → 240 ======================
-    else if (src_w == 180) {
-        // 计算目标行范围
-        dst_y0 = (src_y0 * 240 + 120) / 180;  // 四舍五入
-        dst_lines = (src_lines * 240 + 179) / 180; // 向上取整
-        // 检查缓冲区是否足够
-        if (dst_lines > RGB_LINE_BATCH) {
-            f->state = BUF_FREE;
-            udp.flush();
-            return true;
-        }
-        if (is_rgb565) {
-            scale_180_to_240_rgb565(
-                (uint16_t*)rxBuf,
-                dst,
-                src_lines
-            );
-        } else {
-            scale_180_to_240_rgb332(
-                rxBuf,
-                dst,
-                src_lines
-            );
-        }
-    }
-    // =============== 120 → 240 ======================
-    else if (src_w == 120) {
-        // 计算目标行范围
-        dst_y0 = src_y0 * 2;
-        dst_lines = src_lines * 2;
-        // 确保不超出240边界
-        if (dst_y0 + dst_lines > 240) {
-            dst_lines = 240 - dst_y0;
-        }
-
-        // 检查缓冲区是否足够
-        if (dst_lines > RGB_LINE_BATCH) {
-            // 如果超出，调整接收到的行数
-            int max_src_lines = RGB_LINE_BATCH / 2;
-            if (src_lines > max_src_lines) {
-                src_lines = max_src_lines;
-                dst_lines = max_src_lines * 2;
-            }
-        }
-
-        if (is_rgb565) {
-            scale_120_to_240_rgb565((uint16_t*)rxBuf,
-            dst,
-            src_lines);
-        } else {
-            scale_120_to_240_rgb332(
-                (uint8_t*)rxBuf,
-                dst,
-                src_lines);
-        }
-    }
 
-    // ------------------ 提交 ------------------
-    f->frame_id = frame_id;
-    f->y_start = dst_y0;
-    f->line_count = dst_lines;
-    f->state = BUF_READY;
-    
-    return true;
+#if PIPELINE_EVENT_DRIVEN
+static void notifyDrawTask(void*) {
+    xTaskNotifyGive(drawTaskHandle);
 }
+#endif
+
 // ================= Draw Task =================
  void drawTask(void* param) {
     bool last_power_mode = power_save_mode;
@@ -227,57 +62,22 @@ IRAM_ATTR  bool processUDPPacket() {
         if(power_save_mode){
             if(last_power_mode != power_save_mode) {
                 Serial.println("设置一次黑屏,进入省电模式");
-                tft->fillScreen(TFT_BLACK);
+                drawer->blank(); // 内部等 DMA 发完，队列里的槽位全部还回去
                 last_power_mode = power_save_mode;
             }
             vTaskDelay(100);
             continue;
         }
-        FrameData* f = nullptr;
         last_power_mode = power_save_mode;
-        // 找 READY 的缓冲区
-        for (int i = 0; i < FRAME_BUF_COUNT; i++) {
-            if (frameBuf[i].state == BUF_READY) {
-                f = &frameBuf[i];
-                break;
-            }
-        }
-
-        if (!f) {
+        if (!drawer->drawOnce()) {
+            bool pending = drawer->idle(); // 顺便回收已经发完的槽位
+#if PIPELINE_EVENT_DRIVEN
+            // 睡到 UDP 线程提交 band 为止；超时只是为了回收 DMA 槽位、整帧超时和检查省电模式
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(pending ? 1 : DRAW_IDLE_WAIT_MS));
+#else
             vTaskDelay(1); // 没有数据时短暂延时
-            continue;
+#endif
         }
-
-        f->state = BUF_DISPLAYING;
-
-        uint8_t nextDma = dmaSel ^ 1;
-
-        // 等待 DMA 完成
-        tft->dmaWait();
-
-        memcpy(
-            dmaBuf[nextDma],
-            f->lines,
-            IMG_W * f->line_count * 2
-        );
-
-        tft->startWrite();
-        tft->pushImageDMA(
-            0,
-            f->y_start,
-            IMG_W,
-            f->line_count,
-            dmaBuf[nextDma]
-        );
-        tft->endWrite();
-
-        dmaSel = nextDma;
-        f->state = BUF_FREE;
-        frameCount++;
-        
-        // 如果需要，可以在这里添加小的延时来控制绘制频率
-        // vTaskDelay(1);
-
     }
 }
 
@@ -287,8 +87,17 @@ void setup() {
     tft_init();
     setCpuFrequencyMhz(240);
     
-    tft->initDMA();
-    tft->setSwapBytes(true);
+    pool.evictStale = EVICT_STALE_BANDS;
+    panel = new TftPanel(tft, DMA_QUEUE_DEPTH);
+    if (!panel->begin()) {
+        Serial.println("DMA queue init failed");
+        while (1);
+    }
+    drawer = new BandDrawer(pool, *panel);
+    drawer->begin();
+    if (!drawer->setPresentMode(PRESENT_FRACTION, PRESENT_DEADLINE_MS * 1000)) {
+        Serial.println("整帧缓冲申请失败，使用流式显示");
+    }
 
     tft->setTextFont(1);
     tft->fillScreen(TFT_BLACK);
@@ -300,27 +109,20 @@ void setup() {
     NetworkConfig::begin();   // ⭐ 一行解决 WiFi / AP / 配网
     Serial.println("\nWiFi connected");
 
-    udp.begin(UDP_PORT);
-
-    for (int i = 0; i < FRAME_BUF_COUNT; i++) {
-        frameBuf[i].state = BUF_FREE;
+    if (!transport.begin(UDP_PORT)) {
+        Serial.println("UDP socket failed");
+        while (1);
     }
-    init_scale_maps();
-
-    // 分配 DMA 缓冲区
-    dmaBuf[0] = (uint16_t*)heap_caps_malloc(
-        IMG_W * RGB_LINE_BATCH * 2,
-        MALLOC_CAP_DMA
-    );
-    dmaBuf[1] = (uint16_t*)heap_caps_malloc(
-        IMG_W * RGB_LINE_BATCH * 2,
-        MALLOC_CAP_DMA
-    );
+    Serial.printf("SO_RCVBUF: %d\n", transport.rcvbuf());
 
-    if (!dmaBuf[0] || !dmaBuf[1]) {
+    // 分配 DMA 缓冲区：每个槽位一块，再加一块转换用的
+    if (!pool.begin() || !receiver.begin()) {
         Serial.println("DMA alloc failed");
         while (1);
     }
+    if (!pool.beginBig(BIG_SLOTS)) {
+        Serial.printf("大槽位只申请到 %d 个\n", pool.bigCount());
+    }
 
     // 创建绘制任务（运行在核心0或1，根据需求调整）
     xTaskCreatePinnedToCore(
@@ -329,9 +131,14 @@ void setup() {
         4096,  // 绘制任务不需要太大栈空间
         nullptr,
         2,     // 优先级可以调整
-        nullptr,
+        &drawTaskHandle,
         1      // 核心1
     );
+#if PIPELINE_EVENT_DRIVEN
+    receiver.setCommitHook(notifyDrawTask, nullptr);
+#endif
+    feedback.setInterval(FEEDBACK_INTERVAL_MS);
+    receiver.nack.setDelay(NACK_DELAY_MS);
     
     tft->fillScreen(TFT_BLACK);
     String wifi_str = WiFi.localIP().toString() + ":8888";
@@ -345,22 +152,48 @@ void setup() {
 }
 
 // ================= Debug Info =================
+// 延迟分布，单位 us
+static void printLatency(const char* name, const LatencyHist& h) {
+    Serial.print(name);
+    uint32_t limit = 64;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (i < LATENCY_BUCKETS - 1) Serial.printf("<%u:%u ", limit, h.b[i]);
+        else Serial.printf(">=%u:%u", limit >> 1, h.b[i]);
+        limit <<= 1;
+    }
+    Serial.println();
+}
+
 void printDebugInfo() {
     static uint32_t lastPrint = 0;
+    static DrawStats lastDraw; // 绘制任务的计数器不能在这里清零，按和上一次快照的差值算
     uint32_t now = millis();
     
     if (now - lastPrint > 5000) {
         lastPrint = now;
+        DrawStats d;
+        drawer->snapshot(d);
+        DrawStats cur = d;
+        d.subtract(lastDraw);
+        lastDraw = cur;
         
         Serial.printf("内存: %u, ", ESP.getFreeHeap());
-        Serial.printf("UDP包/5秒: %u, ", udpPackets);
-        Serial.printf("丢包数: %u, ", dropCount);
-        Serial.printf("显示帧数: %u, ", frameCount);
+        Serial.printf("UDP包/5秒: %u, ", receiver.packets);
+        Serial.printf("丢包(无槽位/过期/回收): %u/%u/%u, ", receiver.dropNoSlot, receiver.dropLate, d.evicted);
+        Serial.printf("坏包数: %u, ", receiver.bad);
+        Serial.printf("多band包/拆出band: %u/%u, ", receiver.multis, receiver.multiBands);
+        Serial.printf("分片/拼好/超时: %u/%u/%u, ", receiver.frags, receiver.reasm.bands, receiver.reasm.timeouts);
+        Serial.printf("FEC补回/补不回: %u/%u, ", receiver.fec.recovered, receiver.fec.unrecoverable);
+        Serial.printf("NACK/重发/重发太晚: %u/%u/%u, ", receiver.nack.nacks, receiver.retx, receiver.dropRetx);
+        Serial.printf("重复band: %u, ", receiver.dropDup);
+        Serial.printf("显示band数: %u, ", d.bands);
+        Serial.printf("合并band数: %u, ", d.mergedBands);
+        Serial.printf("包/唤醒: %.1f, ", transport.wakeups() ? (float)transport.datagrams() / transport.wakeups() : 0.0f);
         
         // 显示缓冲区状态
         Serial.print("缓冲区状态: ");
         for (int i = 0; i < FRAME_BUF_COUNT; i++) {
-            switch(frameBuf[i].state) {
+            switch(pool.slots[i].state) {
                 case BUF_FREE: Serial.print("F"); break;
                 case BUF_FILLING: Serial.print("I"); break;
                 case BUF_READY: Serial.print("R"); break;
@@ -368,23 +201,52 @@ void printDebugInfo() {
             }
         }
         Serial.println();
+
+        // 每帧完整度：收到的行数 / 240
+        Serial.printf("帧数: %u, 完整帧: %u, 平均完整度: %.1f%%, 旧帧条带: %u, 迟到band: %u, 越界band: %u\n",
+                      d.frames, d.completeFrames,
+                      d.frames ? d.rowsSum * 100.0f / (d.frames * IMG_H) : 0.0f,
+                      d.staleStripes, d.lateBands, d.rejected);
+        printLatency("提交→DMA延迟: ", d.latency);
+        printLatency("帧显示延迟: ", d.presentLatency);
         
-        udpPackets = 0;
-        frameCount = 0;
+        receiver.packets = 0;
+        receiver.dropNoSlot = 0;
+        receiver.dropLate = 0;
     }
 }
 
 // ================= Loop =================
 void loop() {
-    // 处理所有可用的UDP包
-    bool packetProcessed = true;
-    while (packetProcessed) {
-        packetProcessed = processUDPPacket();
+#if PIPELINE_EVENT_DRIVEN
+    // 没有包时睡在 select 上，不再空转
+    if (!transport.wait(NACK_DELAY_MS ? NACK_DELAY_MS : UDP_WAIT_MS)) {
+        receiver.nack.tick(millis()); // 帧停下来以后还缺的行
+        receiver.reasm.tick(millis());
+        if (millis() - receiver.lastReceiveMs > 5000) {  // 超过5秒没收到数据，进入省电模式
+            power_save_mode = true;
+        }
+        return;
+    }
+#endif
+    // 一次唤醒把排队的包尽量收完
+    for (int i = 0; i < UDP_DRAIN_MAX && receiver.poll(); i++) {
+    }
+    feedback.tick(millis(), receiver.packetsTotal, receiver.dropsTotal + drawer->evicted, drawer->bands);
+    receiver.nack.tick(millis());
+    if (millis() - receiver.lastReceiveMs <= 5000) {
+        power_save_mode = false;
     }
     // 显示调试信息
     // printDebugInfo();
-    
+
+#if !PIPELINE_EVENT_DRIVEN
+    if (millis() - receiver.lastReceiveMs > 5000) {  // 超过5秒没收到数据，进入省电模式
+        power_save_mode = true;
+        delay(10);
+    }
     // 短暂延时，防止过度占用CPU
     // delay(1);
     delayMicroseconds(50);
-}
\ No newline at end of file
+#endif
+}
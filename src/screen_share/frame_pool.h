@@ -0,0 +1,155 @@
+#pragma once
+#include "platform.h"
+#include "band_protocol.h"
+#include "spsc_ring.h"
+#include <atomic>
+
+// ================= Frame Buffer =================
+#define RGB_LINE_BATCH 8  // 需要足够大，因为放大后行数可能增加
+#define FRAME_BUF_COUNT 12 // 214492
+#define SLOT_BYTES (IMG_W * RGB_LINE_BATCH * 2)
+// 分片 band 拼好后放进大槽位，一个大槽位 FRAG_MAX_LINES 行；beginBig 之前不占内存
+#define BIG_SLOT_BYTES (IMG_W * FRAG_MAX_LINES * 2)
+#define BIG_SLOT_MAX 4
+#define SLOT_TOTAL (FRAME_BUF_COUNT + BIG_SLOT_MAX)
+
+enum BufState {
+    BUF_FREE,
+    BUF_FILLING,
+    BUF_READY,
+    BUF_DISPLAYING
+};
+
+struct FrameData {
+    uint16_t frame_id;// = (header[0] << 8) | header[1];
+    uint16_t y_start;
+    uint16_t line_count;
+    uint16_t x_start;  // band 是 0/240，瓦片是屏幕上的矩形
+    uint16_t width;    // lines 按 width 紧排
+    uint16_t* lines; // DMA 内存，SLOT_BYTES 大小，绘制线程直接拿去 DMA
+    uint32_t commit_us; // 提交到 readyRing 的时间，用来统计提交→DMA 开始的延迟
+    volatile BufState state; // 只给调试输出显示用，槽位归属以下面两个队列为准
+};
+
+// 收包线程和绘制线程之间的槽位池。
+// 空闲槽位: 绘制线程生产 → 收包线程消费；就绪槽位: 收包线程生产 → 绘制线程消费
+// 两个队列都按到达顺序出队，绘制顺序和收包顺序一致。
+// slots[FRAME_BUF_COUNT..] 是大槽位，有自己的空闲队列，只给分片重组用（见 band_reassembly.h）
+class FramePool {
+public:
+    FramePool() : evictStale(true), bigCount_(0), rxSlot_(-1), newest_(-1), starved_(false) {}
+
+    // 分配所有槽位，失败返回 false
+    bool begin() {
+        for (int i = 0; i < FRAME_BUF_COUNT; i++) {
+            slots[i].lines = (uint16_t*)dma_alloc(SLOT_BYTES);
+            if (!slots[i].lines) return false;
+            slots[i].state = BUF_FREE;
+            freeRing_.push(i);
+        }
+        return true;
+    }
+
+    // 再分配 n 个大槽位（最多 BIG_SLOT_MAX），失败返回 false，已经分配的照样能用
+    bool beginBig(int n) {
+        if (n > BIG_SLOT_MAX) n = BIG_SLOT_MAX;
+        for (; bigCount_ < n; bigCount_++) {
+            FrameData& f = slots[FRAME_BUF_COUNT + bigCount_];
+            f.lines = (uint16_t*)dma_alloc(BIG_SLOT_BYTES);
+            if (!f.lines) return false;
+            f.state = BUF_FREE;
+            bigFree_.push(FRAME_BUF_COUNT + bigCount_);
+        }
+        return true;
+    }
+    int bigCount() const { return bigCount_; }
+
+    // ---------- 收包线程 ----------
+    // 取一个槽位来接收，没有空槽位返回 nullptr。
+    // 收包线程不是 freeRing 的生产者，取出后没用上的槽位不能放回去，留给下一个包用
+    FrameData* acquire() {
+        if (rxSlot_ < 0) {
+            uint8_t idx;
+            if (!freeRing_.pop(idx)) {
+                starved_.store(true, std::memory_order_relaxed);
+                return nullptr;
+            }
+            rxSlot_ = idx;
+            starved_.store(false, std::memory_order_relaxed);
+        }
+        FrameData* f = &slots[rxSlot_];
+        f->state = BUF_FILLING;
+        return f;
+    }
+
+    // 下一次 acquire 能拿到槽位
+    bool canAcquire() const { return rxSlot_ >= 0 || freeRing_.size() > 0; }
+
+    // 把 acquire 拿到的槽位交给绘制线程
+    void commit() {
+        slots[rxSlot_].commit_us = micros();
+        slots[rxSlot_].state = BUF_READY;
+        readyRing_.push((uint8_t)rxSlot_); // 槽位总数（含大槽位） == 队列容量，不会满
+        rxSlot_ = -1;
+    }
+
+    // 取一个大槽位，没有返回 -1。和 acquire 一样，取出后没用上也不能放回去，由调用方留着下次用
+    int acquireBig() {
+        uint8_t idx;
+        if (!bigFree_.pop(idx)) return -1;
+        slots[idx].state = BUF_FILLING;
+        return idx;
+    }
+
+    // 把 acquireBig 拿到的大槽位交给绘制线程
+    void commitBig(uint8_t idx) {
+        slots[idx].commit_us = micros();
+        slots[idx].state = BUF_READY;
+        readyRing_.push(idx);
+    }
+
+    // ---------- 绘制线程 ----------
+    bool popReady(uint8_t& idx) { return readyRing_.pop(idx); }
+    bool peekReady(size_t i, uint8_t& idx) const { return readyRing_.peek(i, idx); }
+
+    // 槽位发完了，还给收包线程
+    void release(uint8_t idx) {
+        slots[idx].state = BUF_FREE;
+        if (idx >= FRAME_BUF_COUNT) bigFree_.push(idx);
+        else freeRing_.push(idx);
+    }
+
+    // ---------- 过期帧 ----------
+    // 收包线程收到一帧的 band 后调用，记下已经开始的最新帧
+    void noteFrame(uint16_t id) {
+        int32_t n = newest_.load(std::memory_order_relaxed);
+        if (n < 0 || frame_newer(id, (uint16_t)n) || frame_restarted(id, (uint16_t)n)) {
+            newest_.store(id, std::memory_order_relaxed);
+        }
+    }
+
+    // 这一帧已经被更新的帧取代了（两个线程都可以调用）
+    bool isStale(uint16_t id) const {
+        if (!evictStale) return false;
+        int32_t n = newest_.load(std::memory_order_relaxed);
+        return n >= 0 && frame_newer((uint16_t)n, id) && !frame_restarted(id, (uint16_t)n);
+    }
+
+    // 收包线程上一次 acquire 没拿到槽位，之后还没拿到过。绘制线程按这个决定要不要回收过期帧的 band
+    bool starved() const { return starved_.load(std::memory_order_relaxed); }
+
+    size_t freeCount() const { return freeRing_.size(); }
+    size_t readyCount() const { return readyRing_.size(); }
+
+    FrameData slots[SLOT_TOTAL];
+    bool evictStale; // 丢掉/回收过期帧的 band，启动前设置
+
+private:
+    SpscRing<uint8_t, FRAME_BUF_COUNT> freeRing_;
+    SpscRing<uint8_t, BIG_SLOT_MAX> bigFree_;
+    SpscRing<uint8_t, SLOT_TOTAL> readyRing_;
+    int bigCount_;
+    int rxSlot_;
+    std::atomic<int32_t> newest_; // 已经开始的最新帧号，-1 表示还没有
+    std::atomic<bool> starved_;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include "band_protocol.h"
+
+#define FRAME_ROW_WORDS ((IMG_H + 31) / 32)
+
+// ================= 一帧的完成位图 =================
+// 按屏幕行（240 行，放大之后的坐标）记录这一帧哪些行已经收到
+struct FrameTracker {
+    uint16_t frame_id;
+    bool active;          // 正在收这一帧
+    uint16_t rowCount;    // 收到的不重复行数
+    uint32_t first_us;    // 第一条 band 提交的时间
+    uint32_t rows[FRAME_ROW_WORDS];
+
+    FrameTracker() : frame_id(0), active(false), rowCount(0), first_us(0) { clearRows(); }
+
+    void start(uint16_t id, uint32_t now_us) {
+        frame_id = id;
+        active = true;
+        rowCount = 0;
+        first_us = now_us;
+        clearRows();
+    }
+
+    // 标记 [y0, y0+n) 行，返回新增的行数
+    int mark(int y0, int n) {
+        int added = 0;
+        for (int y = y0; y < y0 + n && y < IMG_H; y++) {
+            uint32_t bit = 1u << (y & 31);
+            if (!(rows[y >> 5] & bit)) {
+                rows[y >> 5] |= bit;
+                added++;
+            }
+        }
+        rowCount += added;
+        return added;
+    }
+
+    bool has(int y) const { return (rows[y >> 5] >> (y & 31)) & 1; }
+    // 没收到的连续行段数，屏幕上这些地方还是旧帧的内容
+    int gaps() const {
+        int n = 0;
+        for (int y = 0; y < IMG_H; y++) {
+            if (!has(y) && (y == 0 || has(y - 1))) n++;
+        }
+        return n;
+    }
+    bool complete() const { return rowCount >= IMG_H; }
+
+private:
+    void clearRows() {
+        for (int i = 0; i < FRAME_ROW_WORDS; i++) rows[i] = 0;
+    }
+};
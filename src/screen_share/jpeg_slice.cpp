@@ -0,0 +1,36 @@
+#include "jpeg_slice.h"
+#include <string.h>
+#include <TJpg_Decoder.h>
+
+// TJpgDec 的回调没有用户参数，解码只在收包线程里做，输出位置放在这里
+static uint16_t* sliceOut = nullptr;
+static int sliceW = 0;
+static int sliceH = 0;
+
+// 每次给一个 MCU（最大 16x8，右边、下边已经按图像大小裁过）
+static bool sliceOutput(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* data) {
+    if (x < 0 || y < 0 || x + w > sliceW || y + h > sliceH) return false;
+    uint16_t* d = sliceOut + y * sliceW + x;
+    for (int r = 0; r < h; r++) {
+        memcpy(d, data, w * 2);
+        d += sliceW;
+        data += w;
+    }
+    return true;
+}
+
+bool jpeg_slice_decode(const uint8_t* in, uint32_t len, int w, int lines, uint16_t* out) {
+    static bool ready = false;
+    if (!ready) {
+        TJpgDec.setJpgScale(1);
+        TJpgDec.setSwapBytes(true); // 直接出屏幕字节序
+        TJpgDec.setCallback(sliceOutput);
+        ready = true;
+    }
+    uint16_t jw = 0, jh = 0;
+    if (TJpgDec.getJpgSize(&jw, &jh, in, len) != JDR_OK || jw != w || jh != lines) return false;
+    sliceOut = out;
+    sliceW = w;
+    sliceH = lines;
+    return TJpgDec.drawJpg(0, 0, in, len) == JDR_OK;
+}
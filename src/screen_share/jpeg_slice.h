@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+
+// ================= JPEG 切片（BAND_CODEC_JPEG） =================
+// 每个 band 是一张独立的小 JPEG，丢一个包只丢这几行，不像 TCP 整帧 JPEG 那样卡住后面所有数据。
+// 发送端用 4:2:2 采样（MCU 16x8），8 行一个 band 正好一行 MCU；接收端放大后也不能超过一个槽位，
+// 所以 180 最多 6 行、120 最多 4 行。
+// ESP32 上用 TJpg_Decoder，MCU 在输出回调里直接拷进 out（240 时就是 DMA 缓冲）；
+// PC 上（env:native）用 libjpeg，见 host/jpeg_slice_host.cpp。
+
+// 解成大端 RGB565 按行紧排写进 out。图像宽不是 w、高不是 lines 或者数据坏了返回 false
+bool jpeg_slice_decode(const uint8_t* in, uint32_t len, int w, int lines, uint16_t* out);
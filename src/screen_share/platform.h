@@ -0,0 +1,35 @@
+#pragma once
+// ================= 平台适配 =================
+// 收包/缓冲/缩放/绘制调度这几个模块只依赖这里的几样东西，
+// ESP32 上直接用 Arduino/IDF 的实现，PC 上（env:native）用标准库补上。
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// SPI DMA 只能读内部 RAM
+static inline void* dma_alloc(size_t n) { return heap_caps_malloc(n, MALLOC_CAP_DMA); }
+static inline void dma_free(void* p) { heap_caps_free(p); }
+
+#else
+#include <stdlib.h>
+#include <chrono>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+static inline uint32_t micros() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static inline uint32_t millis() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 放大函数按 32 位写像素，和 DMA 内存一样保证 4 字节对齐
+static inline void* dma_alloc(size_t n) { return aligned_alloc(4, (n + 3) & ~(size_t)3); }
+static inline void dma_free(void* p) { free(p); }
+#endif
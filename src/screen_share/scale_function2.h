@@ -2,6 +2,8 @@
 #define MY_SCALE_FUNCTION_H // 那么定义这个宏，并编译下面的内容
 
 #include <stdint.h>
+#include <string.h>
+#include "platform.h"
 
 
 // ================= RGB332 → RGB565 =================
@@ -63,8 +65,8 @@ DRAM_ATTR static const uint16_t rgb332_to_565_lut[256] = {
 // 预计算映射表
 DRAM_ATTR static int scale_x_map[240];  // 水平映射表
 DRAM_ATTR static int scale_y_map[240];  // 垂直映射表（最大支持240行）
-// 初始化映射表（在setup中调用）
-void init_scale_maps() {
+// 初始化映射表（在setup中调用），映射表每个 .cpp 各一份，只有 band_receiver.cpp 用到
+static inline void init_scale_maps() {
     // 计算水平映射
     for (int dst_x = 0; dst_x < 240; dst_x++) {
         scale_x_map[dst_x] = (dst_x * 180 + 120) / 240;  // 四舍五入
@@ -83,7 +85,7 @@ void init_scale_maps() {
 }
 // 最近邻插值放大 180→240 (放大系数 1.333:1)
 // 使用映射表的缩放函数
-IRAM_ATTR  static void scale_180_to_240_rgb565(
+IRAM_ATTR static inline void scale_180_to_240_rgb565(
     const uint16_t* src,
     uint16_t* dst,
     int src_lines
@@ -110,7 +112,7 @@ IRAM_ATTR  static void scale_180_to_240_rgb565(
     }
 }
 
-IRAM_ATTR static void scale_180_to_240_rgb332(
+IRAM_ATTR static inline void scale_180_to_240_rgb332(
     const uint8_t* src,
     uint16_t* dst,
     int src_lines
@@ -139,7 +141,7 @@ IRAM_ATTR static void scale_180_to_240_rgb332(
 
 
 // 最近邻插值放大 120→240 (放大系数 2:1)
-IRAM_ATTR static void scale_120_to_240_rgb565(
+IRAM_ATTR static inline void scale_120_to_240_rgb565(
     const uint16_t* src,
     uint16_t* dst,
     int src_lines
@@ -158,7 +160,7 @@ IRAM_ATTR static void scale_120_to_240_rgb565(
         }
     }
 }
-IRAM_ATTR static void scale_120_to_240_rgb332(
+IRAM_ATTR static inline void scale_120_to_240_rgb332(
     const uint8_t* src,
     uint16_t* dst,
     int src_lines
@@ -178,4 +180,540 @@ IRAM_ATTR static void scale_120_to_240_rgb332(
     }
 }
 
-#endif
\ No newline at end of file
+// ================= 屏幕字节序（大端）版本 =================
+// ST7789 按高字节在前接收像素。上面的函数输出的是 ESP32 本机的小端 RGB565，
+// 需要 setSwapBytes(true)，pushImageDMA 会在发送前把整条 band 再逐像素翻转一遍。
+// 下面的 _be 版本在查表/放大时就直接写出大端像素，setSwapBytes(false) 即可，省掉这一整遍。
+
+// 由python自动生成
+/*
+def rgb332_to_565be(c):
+    v = ((c & 0xE0) << 8) | ((c & 0x1C) << 6) | ((c & 0x03) << 3)
+    return ((v & 0xFF) << 8) | (v >> 8)
+*/
+DRAM_ATTR static const uint16_t rgb332_to_565be_lut[256] = {
+0x0000,0x0800,0x1000,0x1800,0x0001,0x0801,0x1001,0x1801,
+0x0002,0x0802,0x1002,0x1802,0x0003,0x0803,0x1003,0x1803,
+0x0004,0x0804,0x1004,0x1804,0x0005,0x0805,0x1005,0x1805,
+0x0006,0x0806,0x1006,0x1806,0x0007,0x0807,0x1007,0x1807,
+0x0020,0x0820,0x1020,0x1820,0x0021,0x0821,0x1021,0x1821,
+0x0022,0x0822,0x1022,0x1822,0x0023,0x0823,0x1023,0x1823,
+0x0024,0x0824,0x1024,0x1824,0x0025,0x0825,0x1025,0x1825,
+0x0026,0x0826,0x1026,0x1826,0x0027,0x0827,0x1027,0x1827,
+0x0040,0x0840,0x1040,0x1840,0x0041,0x0841,0x1041,0x1841,
+0x0042,0x0842,0x1042,0x1842,0x0043,0x0843,0x1043,0x1843,
+0x0044,0x0844,0x1044,0x1844,0x0045,0x0845,0x1045,0x1845,
+0x0046,0x0846,0x1046,0x1846,0x0047,0x0847,0x1047,0x1847,
+0x0060,0x0860,0x1060,0x1860,0x0061,0x0861,0x1061,0x1861,
+0x0062,0x0862,0x1062,0x1862,0x0063,0x0863,0x1063,0x1863,
+0x0064,0x0864,0x1064,0x1864,0x0065,0x0865,0x1065,0x1865,
+0x0066,0x0866,0x1066,0x1866,0x0067,0x0867,0x1067,0x1867,
+0x0080,0x0880,0x1080,0x1880,0x0081,0x0881,0x1081,0x1881,
+0x0082,0x0882,0x1082,0x1882,0x0083,0x0883,0x1083,0x1883,
+0x0084,0x0884,0x1084,0x1884,0x0085,0x0885,0x1085,0x1885,
+0x0086,0x0886,0x1086,0x1886,0x0087,0x0887,0x1087,0x1887,
+0x00A0,0x08A0,0x10A0,0x18A0,0x00A1,0x08A1,0x10A1,0x18A1,
+0x00A2,0x08A2,0x10A2,0x18A2,0x00A3,0x08A3,0x10A3,0x18A3,
+0x00A4,0x08A4,0x10A4,0x18A4,0x00A5,0x08A5,0x10A5,0x18A5,
+0x00A6,0x08A6,0x10A6,0x18A6,0x00A7,0x08A7,0x10A7,0x18A7,
+0x00C0,0x08C0,0x10C0,0x18C0,0x00C1,0x08C1,0x10C1,0x18C1,
+0x00C2,0x08C2,0x10C2,0x18C2,0x00C3,0x08C3,0x10C3,0x18C3,
+0x00C4,0x08C4,0x10C4,0x18C4,0x00C5,0x08C5,0x10C5,0x18C5,
+0x00C6,0x08C6,0x10C6,0x18C6,0x00C7,0x08C7,0x10C7,0x18C7,
+0x00E0,0x08E0,0x10E0,0x18E0,0x00E1,0x08E1,0x10E1,0x18E1,
+0x00E2,0x08E2,0x10E2,0x18E2,0x00E3,0x08E3,0x10E3,0x18E3,
+0x00E4,0x08E4,0x10E4,0x18E4,0x00E5,0x08E5,0x10E5,0x18E5,
+0x00E6,0x08E6,0x10E6,0x18E6,0x00E7,0x08E7,0x10E7,0x18E7
+};
+
+// 小端 RGB565 → 大端，一次处理两个像素
+IRAM_ATTR static inline uint32_t rgb565_swap2(uint32_t v)
+{
+    return ((v & 0x00FF00FF) << 8) | ((v >> 8) & 0x00FF00FF);
+}
+
+IRAM_ATTR static inline uint16_t rgb565_swap(uint16_t v)
+{
+    return (uint16_t)((v << 8) | (v >> 8));
+}
+
+// 240 宽 RGB565(小端) 原地翻转成大端，buf 需要 4 字节对齐（DMA 内存都是）
+IRAM_ATTR static inline void rgb565_to_be_inplace(uint16_t* buf, int n)
+{
+    uint32_t* p = (uint32_t*)buf;
+    int n2 = n >> 1;
+    while (n2 >= 4) {
+        p[0] = rgb565_swap2(p[0]);
+        p[1] = rgb565_swap2(p[1]);
+        p[2] = rgb565_swap2(p[2]);
+        p[3] = rgb565_swap2(p[3]);
+        p  += 4;
+        n2 -= 4;
+    }
+    while (n2--) {
+        *p = rgb565_swap2(*p);
+        p++;
+    }
+    if (n & 1) {
+        buf[n - 1] = rgb565_swap(buf[n - 1]);
+    }
+}
+
+// 240 宽 RGB332 → 大端 RGB565，指针展开+查表
+IRAM_ATTR static inline void rgb332_to_565be(const uint8_t* src, uint16_t* dst, int n)
+{
+    while (n >= 4) {
+        dst[0] = rgb332_to_565be_lut[src[0]];
+        dst[1] = rgb332_to_565be_lut[src[1]];
+        dst[2] = rgb332_to_565be_lut[src[2]];
+        dst[3] = rgb332_to_565be_lut[src[3]];
+        src += 4;
+        dst += 4;
+        n   -= 4;
+    }
+    while (n--) {
+        *dst++ = rgb332_to_565be_lut[*src++];
+    }
+}
+
+// 180→240，输入小端 RGB565，输出大端
+IRAM_ATTR static inline void scale_180_to_240_rgb565_be(
+    const uint16_t* src,
+    uint16_t* dst,
+    int src_lines
+) {
+    int dst_lines = (src_lines * 240 + 179) / 180;
+
+    for (int dst_y = 0; dst_y < dst_lines; dst_y++) {
+        int src_y = scale_y_map[dst_y];
+        if (src_y >= src_lines) src_y = src_lines - 1;
+
+        const uint16_t* s = src + src_y * 180;
+        uint16_t* d = dst + dst_y * 240;
+
+        for (int x = 0; x < 180; x += 3) {
+            uint16_t p0 = rgb565_swap(s[x + 0]);
+            uint16_t p1 = rgb565_swap(s[x + 1]);
+            uint16_t p2 = rgb565_swap(s[x + 2]);
+
+            *d++ = p0;
+            *d++ = p0;
+            *d++ = p1;
+            *d++ = p2;
+        }
+    }
+}
+
+IRAM_ATTR static inline void scale_180_to_240_rgb332_be(
+    const uint8_t* src,
+    uint16_t* dst,
+    int src_lines
+) {
+    int dst_lines = (src_lines * 240 + 179) / 180;
+
+    for (int dst_y = 0; dst_y < dst_lines; dst_y++) {
+        int src_y = scale_y_map[dst_y];
+        if (src_y >= src_lines) src_y = src_lines - 1;
+
+        const uint8_t* s = src + src_y * 180;
+        uint16_t* d = dst + dst_y * 240;
+
+        for (int x = 0; x < 180; x += 3) {
+            uint16_t p0 = rgb332_to_565be_lut[s[x + 0]];
+            uint16_t p1 = rgb332_to_565be_lut[s[x + 1]];
+            uint16_t p2 = rgb332_to_565be_lut[s[x + 2]];
+
+            *d++ = p0;
+            *d++ = p0;
+            *d++ = p1;
+            *d++ = p2;
+        }
+    }
+}
+
+// 120→240，输入小端 RGB565，输出大端。横向两个像素相同，直接 32 位写
+IRAM_ATTR static inline void scale_120_to_240_rgb565_be(
+    const uint16_t* src,
+    uint16_t* dst,
+    int src_lines
+) {
+    for (int y = 0; y < src_lines; y++) {
+        const uint16_t* s = src + y * 120;
+        uint32_t* d0 = (uint32_t*)(dst + (y * 2) * 240);
+        uint32_t* d1 = d0 + 120;
+
+        for (int x = 0; x < 120; x++) {
+            uint32_t p = rgb565_swap(s[x]);
+            p |= p << 16;
+            d0[x] = p;
+            d1[x] = p;
+        }
+    }
+}
+
+IRAM_ATTR static inline void scale_120_to_240_rgb332_be(
+    const uint8_t* src,
+    uint16_t* dst,
+    int src_lines
+) {
+    for (int y = 0; y < src_lines; y++) {
+        const uint8_t* s = src + y * 120;
+        uint32_t* d0 = (uint32_t*)(dst + (y * 2) * 240);
+        uint32_t* d1 = d0 + 120;
+
+        for (int x = 0; x < 120; x++) {
+            uint32_t p = rgb332_to_565be_lut[s[x]];
+            p |= p << 16;
+            d0[x] = p;
+            d1[x] = p;
+        }
+    }
+}
+
+// ================= 调色板 =================
+// pal 是收到调色板包时填好的大端 RGB565 表，放在 DRAM 里，结构和上面 332 查表一样，只是表是运行时的。
+// 8 位索引一个字节一个像素；4 位索引一个字节两个像素，高 4 位在前，每行的像素数都是偶数
+
+IRAM_ATTR static inline void pal8_to_565be(const uint8_t* src, const uint16_t* pal, uint16_t* dst, int n)
+{
+    while (n >= 4) {
+        dst[0] = pal[src[0]];
+        dst[1] = pal[src[1]];
+        dst[2] = pal[src[2]];
+        dst[3] = pal[src[3]];
+        src += 4;
+        dst += 4;
+        n   -= 4;
+    }
+    while (n--) {
+        *dst++ = pal[*src++];
+    }
+}
+
+// dst 要 4 字节对齐，一个字节解出的两个像素一次写
+IRAM_ATTR static inline void pal4_to_565be(const uint8_t* src, const uint16_t* pal, uint16_t* dst, int n)
+{
+    uint32_t* d = (uint32_t*)dst;
+    int n2 = n >> 1;
+    while (n2 >= 4) {
+        d[0] = pal[src[0] >> 4] | ((uint32_t)pal[src[0] & 15] << 16);
+        d[1] = pal[src[1] >> 4] | ((uint32_t)pal[src[1] & 15] << 16);
+        d[2] = pal[src[2] >> 4] | ((uint32_t)pal[src[2] & 15] << 16);
+        d[3] = pal[src[3] >> 4] | ((uint32_t)pal[src[3] & 15] << 16);
+        src += 4;
+        d   += 4;
+        n2  -= 4;
+    }
+    while (n2--) {
+        *d++ = pal[*src >> 4] | ((uint32_t)pal[*src & 15] << 16);
+        src++;
+    }
+}
+
+IRAM_ATTR static inline void scale_180_to_240_pal8_be(
+    const uint8_t* src,
+    const uint16_t* pal,
+    uint16_t* dst,
+    int src_lines
+) {
+    int dst_lines = (src_lines * 240 + 179) / 180;
+
+    for (int dst_y = 0; dst_y < dst_lines; dst_y++) {
+        int src_y = scale_y_map[dst_y];
+        if (src_y >= src_lines) src_y = src_lines - 1;
+
+        const uint8_t* s = src + src_y * 180;
+        uint16_t* d = dst + dst_y * 240;
+
+        for (int x = 0; x < 180; x += 3) {
+            uint16_t p0 = pal[s[x + 0]];
+            uint16_t p1 = pal[s[x + 1]];
+            uint16_t p2 = pal[s[x + 2]];
+
+            *d++ = p0;
+            *d++ = p0;
+            *d++ = p1;
+            *d++ = p2;
+        }
+    }
+}
+
+// 一行 90 字节。3 个字节是 6 个源像素，放大成 8 个，按 32 位写 4 次
+IRAM_ATTR static inline void scale_180_to_240_pal4_be(
+    const uint8_t* src,
+    const uint16_t* pal,
+    uint16_t* dst,
+    int src_lines
+) {
+    int dst_lines = (src_lines * 240 + 179) / 180;
+
+    for (int dst_y = 0; dst_y < dst_lines; dst_y++) {
+        int src_y = scale_y_map[dst_y];
+        if (src_y >= src_lines) src_y = src_lines - 1;
+
+        const uint8_t* s = src + src_y * 90;
+        uint32_t* d = (uint32_t*)(dst + dst_y * 240);
+
+        for (int x = 0; x < 90; x += 3) {
+            uint32_t p0 = pal[s[x + 0] >> 4];
+            uint32_t p1 = pal[s[x + 0] & 15];
+            uint32_t p2 = pal[s[x + 1] >> 4];
+            uint32_t p3 = pal[s[x + 1] & 15];
+            uint32_t p4 = pal[s[x + 2] >> 4];
+            uint32_t p5 = pal[s[x + 2] & 15];
+
+            // 0,0,1,2 | 3,3,4,5
+            *d++ = p0 | (p0 << 16);
+            *d++ = p1 | (p2 << 16);
+            *d++ = p3 | (p3 << 16);
+            *d++ = p4 | (p5 << 16);
+        }
+    }
+}
+
+IRAM_ATTR static inline void scale_120_to_240_pal8_be(
+    const uint8_t* src,
+    const uint16_t* pal,
+    uint16_t* dst,
+    int src_lines
+) {
+    for (int y = 0; y < src_lines; y++) {
+        const uint8_t* s = src + y * 120;
+        uint32_t* d0 = (uint32_t*)(dst + (y * 2) * 240);
+        uint32_t* d1 = d0 + 120;
+
+        for (int x = 0; x < 120; x++) {
+            uint32_t p = pal[s[x]];
+            p |= p << 16;
+            d0[x] = p;
+            d1[x] = p;
+        }
+    }
+}
+
+IRAM_ATTR static inline void scale_120_to_240_pal4_be(
+    const uint8_t* src,
+    const uint16_t* pal,
+    uint16_t* dst,
+    int src_lines
+) {
+    for (int y = 0; y < src_lines; y++) {
+        const uint8_t* s = src + y * 60;
+        uint32_t* d0 = (uint32_t*)(dst + (y * 2) * 240);
+        uint32_t* d1 = d0 + 120;
+
+        for (int x = 0; x < 60; x++) {
+            uint32_t p0 = pal[s[x] >> 4];
+            uint32_t p1 = pal[s[x] & 15];
+            p0 |= p0 << 16;
+            p1 |= p1 << 16;
+            d0[2 * x] = p0;
+            d0[2 * x + 1] = p1;
+            d1[2 * x] = p0;
+            d1[2 * x + 1] = p1;
+        }
+    }
+}
+
+// ================= YUV 4:2:0 =================
+// Y 一个像素一个字节，U/V 每 2x2 个像素一个字节，三个平面分开放。JPEG 用的全范围 BT.601：
+//   R = Y + 1.402 (V-128)
+//   G = Y - 0.344 (U-128) - 0.714 (V-128)
+//   B = Y + 1.772 (U-128)
+// 系数放大 65536 取整。一个色度样本算一次三个偏移，它覆盖的 4 个像素只剩加法和截断
+#define YUV_RV 91881
+#define YUV_GU 22554
+#define YUV_GV 46802
+#define YUV_BU 116130
+
+struct YuvChroma {
+    int rv, guv, bu;
+};
+
+static inline YuvChroma yuv_chroma(int u, int v) {
+    u -= 128;
+    v -= 128;
+    YuvChroma c;
+    c.rv = (YUV_RV * v + 32768) >> 16;
+    c.guv = (YUV_GU * u + YUV_GV * v + 32768) >> 16;
+    c.bu = (YUV_BU * u + 32768) >> 16;
+    return c;
+}
+
+static inline uint32_t yuv_clip(int x) {
+    return x < 0 ? 0 : (x > 255 ? 255 : x);
+}
+
+// 直接拼出大端 RGB565：低字节 RRRRRGGG，高字节 GGGBBBBB
+static inline uint32_t yuv_to_565be(int y, const YuvChroma& c) {
+    uint32_t r = yuv_clip(y + c.rv);
+    uint32_t g = yuv_clip(y - c.guv);
+    uint32_t b = yuv_clip(y + c.bu);
+    return (r & 0xF8) | (g >> 5) | ((g & 0x1C) << 11) | ((b & 0xF8) << 5);
+}
+
+// w 是偶数；lines 是奇数时最后一行单独用一行色度。dst 要 4 字节对齐
+IRAM_ATTR static inline void yuv420_to_565be(
+    const uint8_t* y, const uint8_t* u, const uint8_t* v,
+    uint16_t* dst, int w, int lines
+) {
+    int cw = w >> 1;
+    for (int row = 0; row < lines; row += 2) {
+        const uint8_t* y0 = y + row * w;
+        const uint8_t* y1 = y0 + w;
+        uint32_t* d0 = (uint32_t*)(dst + row * w);
+        uint32_t* d1 = d0 + cw;
+        if (row + 1 >= lines) {
+            // 没有第二行就把第一行再写一遍
+            y1 = y0;
+            d1 = d0;
+        }
+        const uint8_t* cu = u + (row >> 1) * cw;
+        const uint8_t* cv = v + (row >> 1) * cw;
+
+        for (int x = 0; x < cw; x++) {
+            YuvChroma c = yuv_chroma(cu[x], cv[x]);
+            d0[x] = yuv_to_565be(y0[2 * x], c) | (yuv_to_565be(y0[2 * x + 1], c) << 16);
+            d1[x] = yuv_to_565be(y1[2 * x], c) | (yuv_to_565be(y1[2 * x + 1], c) << 16);
+        }
+    }
+}
+
+// 180→240，转色和放大一起做。6 个源像素（3 个色度样本）放大成 8 个，按 32 位写 4 次；
+// 一行色度的偏移算好留给下一个源行用，纵向重复的目标行直接复制上一行
+IRAM_ATTR static inline void scale_180_to_240_yuv420_be(
+    const uint8_t* y, const uint8_t* u, const uint8_t* v,
+    uint16_t* dst,
+    int src_lines
+) {
+    int dst_lines = (src_lines * 240 + 179) / 180;
+    int last_y = -1;
+    int chroma_y = -1;
+    YuvChroma c[90];
+
+    for (int dst_y = 0; dst_y < dst_lines; dst_y++) {
+        int src_y = scale_y_map[dst_y];
+        if (src_y >= src_lines) src_y = src_lines - 1;
+
+        uint32_t* d = (uint32_t*)(dst + dst_y * 240);
+        if (src_y == last_y) {
+            memcpy(d, d - 120, 240 * 2);
+            continue;
+        }
+        last_y = src_y;
+
+        if ((src_y >> 1) != chroma_y) {
+            chroma_y = src_y >> 1;
+            const uint8_t* cu = u + chroma_y * 90;
+            const uint8_t* cv = v + chroma_y * 90;
+            for (int x = 0; x < 90; x++) c[x] = yuv_chroma(cu[x], cv[x]);
+        }
+        const uint8_t* s = y + src_y * 180;
+
+        for (int x = 0; x < 90; x += 3) {
+            uint32_t p0 = yuv_to_565be(s[0], c[x + 0]);
+            uint32_t p1 = yuv_to_565be(s[1], c[x + 0]);
+            uint32_t p2 = yuv_to_565be(s[2], c[x + 1]);
+            uint32_t p3 = yuv_to_565be(s[3], c[x + 1]);
+            uint32_t p4 = yuv_to_565be(s[4], c[x + 2]);
+            uint32_t p5 = yuv_to_565be(s[5], c[x + 2]);
+            s += 6;
+
+            // 0,0,1,2 | 3,3,4,5
+            *d++ = p0 | (p0 << 16);
+            *d++ = p1 | (p2 << 16);
+            *d++ = p3 | (p3 << 16);
+            *d++ = p4 | (p5 << 16);
+        }
+    }
+}
+
+// 120→240，一个色度样本覆盖 2x2 个源像素，也就是 4x4 个目标像素
+IRAM_ATTR static inline void scale_120_to_240_yuv420_be(
+    const uint8_t* y, const uint8_t* u, const uint8_t* v,
+    uint16_t* dst,
+    int src_lines
+) {
+    for (int row = 0; row < src_lines; row += 2) {
+        const uint8_t* y0 = y + row * 120;
+        const uint8_t* y1 = y0 + 120;
+        uint32_t* d0 = (uint32_t*)(dst + (row * 2) * 240);
+        uint32_t* d1 = d0 + 240; // 第二个源行对应的两行，往下数两行
+        if (row + 1 >= src_lines) {
+            y1 = y0;
+            d1 = d0;
+        }
+        const uint8_t* cu = u + (row >> 1) * 60;
+        const uint8_t* cv = v + (row >> 1) * 60;
+
+        for (int x = 0; x < 60; x++) {
+            YuvChroma c = yuv_chroma(cu[x], cv[x]);
+            uint32_t p0 = yuv_to_565be(y0[2 * x], c);
+            uint32_t p1 = yuv_to_565be(y0[2 * x + 1], c);
+            uint32_t p2 = yuv_to_565be(y1[2 * x], c);
+            uint32_t p3 = yuv_to_565be(y1[2 * x + 1], c);
+            p0 |= p0 << 16;
+            p1 |= p1 << 16;
+            p2 |= p2 << 16;
+            p3 |= p3 << 16;
+            d0[2 * x] = p0;
+            d0[2 * x + 1] = p1;
+            d0[120 + 2 * x] = p0;
+            d0[120 + 2 * x + 1] = p1;
+            d1[2 * x] = p2;
+            d1[2 * x + 1] = p3;
+            d1[120 + 2 * x] = p2;
+            d1[120 + 2 * x + 1] = p3;
+        }
+    }
+}
+
+// ================= 瓦片（任意矩形） =================
+// 输入是 w*h 的源像素（color: 0=小端565,1=332,2=大端565），输出 dw*dh 的大端 RGB565，按行紧排。
+// 瓦片都不大，按颜色分三个循环，不再做展开
+
+// 取源像素并转成大端 RGB565
+IRAM_ATTR static inline uint16_t tile_px_be(const uint8_t* row, int i, int color)
+{
+    if (color == 1) return rgb332_to_565be_lut[row[i]];
+    uint16_t p = ((const uint16_t*)row)[i];
+    return color == 0 ? rgb565_swap(p) : p;
+}
+
+// 180→240，dx0 是瓦片左边在屏幕上的 x，用来对齐 band 的 0,0,1,2 横向规律；sx0 是瓦片左边的源 x
+IRAM_ATTR static inline void scale_tile_180_to_240_be(
+    const uint8_t* src, int color, int sx0, int sw, int sh,
+    uint16_t* dst, int dx0, int dw, int dh
+) {
+    int bpp = color == 1 ? 1 : 2;
+    for (int dy = 0; dy < dh; dy++) {
+        int sy = scale_y_map[dy];
+        if (sy >= sh) sy = sh - 1;
+        const uint8_t* row = src + sy * sw * bpp;
+        for (int i = 0; i < dw; i++) {
+            int dx = dx0 + i;
+            int j = dx & 3;
+            int sx = (dx >> 2) * 3 + (j ? j - 1 : 0) - sx0;
+            *dst++ = tile_px_be(row, sx, color);
+        }
+    }
+}
+
+// 120→240，每个源像素变成 2x2
+IRAM_ATTR static inline void scale_tile_120_to_240_be(
+    const uint8_t* src, int color, int sw, int sh, uint16_t* dst
+) {
+    int bpp = color == 1 ? 1 : 2;
+    for (int y = 0; y < sh; y++) {
+        const uint8_t* row = src + y * sw * bpp;
+        uint16_t* d0 = dst + (y * 2) * (sw * 2);
+        uint16_t* d1 = d0 + sw * 2;
+        for (int x = 0; x < sw; x++) {
+            uint16_t p = tile_px_be(row, x, color);
+            d0[2 * x] = d0[2 * x + 1] = p;
+            d1[2 * x] = d1[2 * x + 1] = p;
+        }
+    }
+}
+
+#endif
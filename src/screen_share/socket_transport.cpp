@@ -0,0 +1,103 @@
+#include "socket_transport.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#ifdef ARDUINO
+#include <lwip/sockets.h>
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+bool SocketTransport::begin(uint16_t port) {
+    end();
+    sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock_ < 0) return false;
+
+    int one = 1;
+    setsockopt(sock_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // 收包线程偶尔被绘制抢占时靠这块缓冲兜住突发；设置失败不影响使用。
+    // ESP32 上能排队的包数还受 CONFIG_LWIP_UDP_RECVMBOX_SIZE 限制
+    if (rcvbuf_ > 0) {
+        setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &rcvbuf_, sizeof(rcvbuf_));
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        end();
+        return false;
+    }
+    return true;
+}
+
+void SocketTransport::end() {
+    if (sock_ >= 0) {
+        close(sock_);
+        sock_ = -1;
+    }
+}
+
+int SocketTransport::rcvbuf() const {
+    int v = 0;
+    socklen_t len = sizeof(v);
+    if (sock_ < 0 || getsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &v, &len) < 0) return -1;
+    return v;
+}
+
+bool SocketTransport::wait(uint32_t timeout_ms) {
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    FD_SET(sock_, &rfds);
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    if (select(sock_ + 1, &rfds, nullptr, nullptr, &tv) <= 0) return false;
+    wakeups_++;
+    return true;
+}
+
+int SocketTransport::recv(uint8_t* hdr, size_t hdr_len,
+                          uint8_t* payload, size_t payload_cap, bool* truncated) {
+    struct iovec iov[2];
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = hdr_len;
+    iov[1].iov_base = payload;
+    iov[1].iov_len = payload_cap;
+    struct sockaddr_in from;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &from;
+    msg.msg_namelen = sizeof(from);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    int n = recvmsg(sock_, &msg, MSG_DONTWAIT);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    datagrams_++;
+    if (msg.msg_namelen >= sizeof(from)) {
+        peerAddr_ = from.sin_addr.s_addr;
+        peerPort_ = from.sin_port;
+    }
+    if (truncated) *truncated = (msg.msg_flags & MSG_TRUNC) != 0;
+    return n;
+}
+
+bool SocketTransport::reply(const uint8_t* data, size_t len) {
+    if (sock_ < 0 || peerPort_ == 0) return false;
+    struct sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = peerPort_;
+    to.sin_addr.s_addr = peerAddr_;
+    // 发不出去就算了，下一个反馈包会带上最新的统计
+    return sendto(sock_, data, len, MSG_DONTWAIT, (struct sockaddr*)&to, sizeof(to)) == (int)len;
+}
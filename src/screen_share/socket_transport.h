@@ -0,0 +1,36 @@
+#pragma once
+#include "band_transport.h"
+
+// ================= 基于 socket 的 UDP 收包 =================
+// 直接用 recvmsg(MSG_DONTWAIT)，不经过 WiFiUDP 的内部缓冲，头部和负载一次分散读到两处。
+// ESP32 上走 lwIP 的 socket 接口，PC 上走系统 socket，代码相同。
+class SocketTransport : public BandTransport {
+public:
+    // rcvbuf: 申请的 SO_RCVBUF 字节数，0 表示用系统默认
+    explicit SocketTransport(int rcvbuf = 0)
+        : sock_(-1), rcvbuf_(rcvbuf), datagrams_(0), wakeups_(0), peerAddr_(0), peerPort_(0) {}
+    ~SocketTransport() { end(); }
+
+    bool begin(uint16_t port) override;
+    void end() override;
+    bool wait(uint32_t timeout_ms) override;
+    int recv(uint8_t* hdr, size_t hdr_len,
+             uint8_t* payload, size_t payload_cap, bool* truncated) override;
+    bool reply(const uint8_t* data, size_t len) override;
+
+    int fd() const { return sock_; }
+    // 实际生效的 SO_RCVBUF（Linux 上会被翻倍，lwIP 没开 LWIP_SO_RCVBUF 时取不到，返回 -1）
+    int rcvbuf() const;
+    // 收到的数据报数和 wait 成功唤醒次数，两者相除就是每次唤醒平均收了几个包
+    uint32_t datagrams() const { return datagrams_; }
+    uint32_t wakeups() const { return wakeups_; }
+
+private:
+    int sock_;
+    int rcvbuf_;
+    uint32_t datagrams_;
+    uint32_t wakeups_;
+    // 最近一个包的来源，网络字节序，端口是 0 表示还没收到过
+    uint32_t peerAddr_;
+    uint16_t peerPort_;
+};
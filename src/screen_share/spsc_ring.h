@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// ================= SPSC 无锁环形队列 =================
+// 单生产者/单消费者，用来在 UDP 线程和绘制线程之间传递 frameBuf[] 的下标。
+// tail 只由生产者写，head 只由消费者写：
+//   生产者先写槽位再 release 发布 tail，消费者 acquire 读到 tail 后，
+//   槽位里的下标以及下标对应 FrameData 里写好的内容都一定可见，反方向同理。
+// 不依赖 FreeRTOS，ESP32 和 PC 上都能编译。
+template <typename T, size_t N>
+class SpscRing {
+public:
+    SpscRing() : head_(0), tail_(0) {}
+
+    // 生产者调用，队列满返回 false
+    bool push(T v) {
+        uint32_t t = tail_.load(std::memory_order_relaxed);
+        uint32_t next = advance(t);
+        if (next == head_.load(std::memory_order_acquire)) return false;
+        buf_[t] = v;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用，队列空返回 false
+    bool pop(T& out) {
+        uint32_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_.load(std::memory_order_acquire)) return false;
+        out = buf_[h];
+        head_.store(advance(h), std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用，查看队头往后第 i 个元素但不出队
+    bool peek(size_t i, T& out) const {
+        uint32_t h = head_.load(std::memory_order_relaxed);
+        uint32_t t = tail_.load(std::memory_order_acquire);
+        size_t count = t >= h ? t - h : t + (N + 1) - h;
+        if (i >= count) return false;
+        out = buf_[(h + i) % (N + 1)];
+        return true;
+    }
+
+    // 两端都可以调用，结果只是某一时刻的快照
+    size_t size() const {
+        uint32_t h = head_.load(std::memory_order_acquire);
+        uint32_t t = tail_.load(std::memory_order_acquire);
+        return t >= h ? t - h : t + (N + 1) - h;
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    // 多留一个空位区分满/空，N 不要求是 2 的幂（FRAME_BUF_COUNT = 12）
+    static uint32_t advance(uint32_t i) { return i == N ? 0 : i + 1; }
+
+    T buf_[N + 1];
+    std::atomic<uint32_t> head_;
+    std::atomic<uint32_t> tail_;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "common.h"
+#include "band_panel.h"
+
+// ================= TFT_eSPI DMA 队列 → BandPanel =================
+// 完成回调由 TFT_eSPI 在 dmaBusy/dmaWait/排队时的回收里调用，都在绘制线程。
+// DMA 队列建好以后回调就不能换了，所以队列只认 onBlockSent，由它转给 setDoneCallback 设的回调
+class TftPanel : public BandPanel {
+public:
+    TftPanel(TFT_eSPI* tft, uint8_t depth) : tft_(tft), depth_(depth), done_(nullptr) {}
+
+    // tft_init 之后、第一次排队之前调用一次，建 DMA 队列。一个程序里只有一个 TftPanel。失败返回 false
+    bool begin() {
+        active() = this;
+        tft_->setSwapBytes(false); // 槽位里已经是屏幕字节序(大端)，DMA 前不用再翻转
+        return tft_->initDMAQueue(depth_, onBlockSent);
+    }
+
+    void setDoneCallback(void (*cb)(void*)) override { done_ = cb; }
+    void startWrite() override { tft_->startWrite(); }
+    void endWrite() override { tft_->endWrite(); } // 内部 dmaWait
+    bool startWindow(int32_t x, int32_t y, int32_t w, int32_t h,
+                     uint16_t* buf, uint32_t len, void* user) override {
+        return tft_->startWindowDMAQueued(x, y, w, h, buf, len, user);
+    }
+    bool pushPixels(uint16_t* buf, uint32_t len, void* user) override {
+        return tft_->pushPixelsDMAQueued(buf, len, user);
+    }
+    bool busy() override { return tft_->dmaBusy(); }
+    uint8_t queued() override { return tft_->dmaQueued(); }
+    void fillScreen(uint16_t color) override { tft_->fillScreen(color); }
+
+private:
+    static TftPanel*& active() {
+        static TftPanel* panel = nullptr;
+        return panel;
+    }
+    static void onBlockSent(void* user) {
+        TftPanel* p = active();
+        if (p && p->done_) p->done_(user);
+    }
+
+    TFT_eSPI* tft_;
+    uint8_t depth_;
+    void (*done_)(void*);
+};